@@ -0,0 +1,694 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "user_columns.hpp"
+
+//================================
+// 			ARROW IPC
+//================================
+// Writes and maps Arrow IPC *files* (the "ARROW1" random-access format, metadata version V5) holding a
+// two-column utf8 schema {username, email}. Files open in pyarrow/arrow-cpp/polars; our own reader maps the
+// file and hands out StringColumnViews that point into the mapping, so loading copies nothing.
+//
+// Arrow metadata is flatbuffers. Rather than pull in the flatbuffers compiler for five tables, the small
+// builder/reader below encodes exactly the tables we use (Message, Schema, Field, RecordBatch, Footer).
+namespace arrow_ipc {
+
+inline constexpr std::size_t alignment = 64; // Arrow's recommended buffer alignment; keeps column scans SIMD friendly
+
+namespace fb {
+
+// Forward-writing flatbuffer builder: parents are written before children and their offset fields are
+// patched once the child lands (uoffsets must point forward, which this order guarantees).
+class Builder {
+public:
+	Builder() : buf_(4, 0) {} // root offset, patched by finish()
+
+	struct Field {
+		std::uint16_t id;
+		std::uint8_t size;
+		std::uint64_t value; // little-endian scalar; 0 for offset fields that get linked later
+	};
+
+	// Writes vtable + table; `positions` receives the absolute position of each field, in argument order.
+	std::size_t table(std::initializer_list<Field> fields, std::size_t *positions = nullptr) {
+		std::size_t slots = 0;
+		for (const auto &f : fields) {
+			slots = std::max<std::size_t>(slots, f.id + 1u);
+		}
+		const std::size_t vtable_size = 4 + 2 * slots;
+		pad_to(2);
+		const std::size_t vtable = buf_.size();
+		const std::size_t start = align_up(vtable + vtable_size, 4);
+
+		std::size_t cursor = start + 4;
+		std::size_t i = 0;
+		std::array<std::size_t, 16> pos{};
+		for (const auto &f : fields) {
+			cursor = align_up(cursor, f.size); // scalars are naturally aligned, absolutely
+			pos[i++] = cursor;
+			cursor += f.size;
+		}
+		buf_.resize(cursor, 0);
+
+		put<std::uint16_t>(vtable, static_cast<std::uint16_t>(vtable_size));
+		put<std::uint16_t>(vtable + 2, static_cast<std::uint16_t>(cursor - start));
+		i = 0;
+		for (const auto &f : fields) {
+			put<std::uint16_t>(vtable + 4 + 2 * f.id, static_cast<std::uint16_t>(pos[i] - start));
+			std::memcpy(buf_.data() + pos[i], &f.value, f.size);
+			if (positions != nullptr) {
+				positions[i] = pos[i];
+			}
+			++i;
+		}
+		put<std::int32_t>(start, static_cast<std::int32_t>(start - vtable));
+		return start;
+	}
+
+	std::size_t string(std::string_view s) {
+		pad_to(4);
+		const std::size_t at = buf_.size();
+		buf_.resize(at + 4 + s.size() + 1, 0);
+		put<std::uint32_t>(at, static_cast<std::uint32_t>(s.size()));
+		std::memcpy(buf_.data() + at + 4, s.data(), s.size());
+		return at;
+	}
+
+	// Vector of fixed-size structs (already laid out little-endian in `bytes`).
+	std::size_t struct_vector(std::size_t count, std::size_t element_align, std::span<const std::byte> bytes) {
+		pad_to(4);
+		while ((buf_.size() + 4) % element_align != 0) {
+			buf_.push_back(0);
+		}
+		const std::size_t at = buf_.size();
+		buf_.resize(at + 4 + bytes.size(), 0);
+		put<std::uint32_t>(at, static_cast<std::uint32_t>(count));
+		if (!bytes.empty()) {
+			std::memcpy(buf_.data() + at + 4, bytes.data(), bytes.size());
+		}
+		return at;
+	}
+
+	// Vector of table offsets; element i lives at the returned position + 4 + 4 * i and is linked later.
+	std::size_t offset_vector(std::size_t count) {
+		pad_to(4);
+		const std::size_t at = buf_.size();
+		buf_.resize(at + 4 + 4 * count, 0);
+		put<std::uint32_t>(at, static_cast<std::uint32_t>(count));
+		return at;
+	}
+
+	void link(std::size_t field, std::size_t target) {
+		put<std::uint32_t>(field, static_cast<std::uint32_t>(target - field));
+	}
+
+	std::vector<std::uint8_t> finish(std::size_t root) {
+		link(0, root);
+		pad_to(8);
+		return std::move(buf_);
+	}
+
+private:
+	static std::size_t align_up(std::size_t v, std::size_t a) {
+		return (v + a - 1) / a * a;
+	}
+
+	void pad_to(std::size_t a) {
+		buf_.resize(align_up(buf_.size(), a), 0);
+	}
+
+	template<typename T>
+	void put(std::size_t at, T v) {
+		std::memcpy(buf_.data() + at, &v, sizeof(T));
+	}
+
+	std::vector<std::uint8_t> buf_;
+};
+
+[[noreturn]] inline void malformed(const char *what) {
+	throw std::runtime_error(std::string("malformed Arrow file: ") + what);
+}
+
+// Bounds-checked accessor over a flatbuffer table.
+class Table {
+public:
+	Table(std::span<const std::uint8_t> buf, std::size_t pos) : buf_(buf), pos_(pos) {
+		auto vt = static_cast<std::int64_t>(pos) - read<std::int32_t>(pos);
+		if (vt < 0) {
+			malformed("vtable out of range");
+		}
+		vtable_ = static_cast<std::size_t>(vt);
+		vtable_size_ = read<std::uint16_t>(vtable_);
+	}
+
+	static Table root(std::span<const std::uint8_t> buf) {
+		Table probe(buf);
+		return { buf, probe.read<std::uint32_t>(0) };
+	}
+
+	template<typename T>
+	T scalar(std::uint16_t id, T fallback = {}) const {
+		auto at = field(id);
+		return at ? read<T>(*at) : fallback;
+	}
+
+	std::optional<Table> table(std::uint16_t id) const {
+		auto at = field(id);
+		if (!at) {
+			return std::nullopt;
+		}
+		return Table(buf_, *at + read<std::uint32_t>(*at));
+	}
+
+	std::string_view string(std::uint16_t id) const {
+		auto at = field(id);
+		if (!at) {
+			return {};
+		}
+		std::size_t s = *at + read<std::uint32_t>(*at);
+		auto len = read<std::uint32_t>(s);
+		check(s + 4, len);
+		return { reinterpret_cast<const char *>(buf_.data() + s + 4), len };
+	}
+
+	// {position of the first element, element count}; count 0 when absent.
+	std::pair<std::size_t, std::size_t> vector(std::uint16_t id, std::size_t element_size) const {
+		auto at = field(id);
+		if (!at) {
+			return { 0, 0 };
+		}
+		std::size_t v = *at + read<std::uint32_t>(*at);
+		auto count = read<std::uint32_t>(v);
+		check(v + 4, std::size_t{ count } * element_size);
+		return { v + 4, count };
+	}
+
+	Table table_at(std::size_t element) const {
+		return Table(buf_, element + read<std::uint32_t>(element));
+	}
+
+	template<typename T>
+	T read(std::size_t at) const {
+		check(at, sizeof(T));
+		T v;
+		std::memcpy(&v, buf_.data() + at, sizeof(T));
+		return v;
+	}
+
+private:
+	explicit Table(std::span<const std::uint8_t> buf) : buf_(buf) {}
+
+	std::optional<std::size_t> field(std::uint16_t id) const {
+		std::size_t slot = 4 + 2 * static_cast<std::size_t>(id);
+		if (slot + 2 > vtable_size_) {
+			return std::nullopt;
+		}
+		auto off = read<std::uint16_t>(vtable_ + slot);
+		return off == 0 ? std::nullopt : std::optional<std::size_t>(pos_ + off);
+	}
+
+	void check(std::size_t at, std::size_t size) const {
+		if (at > buf_.size() || size > buf_.size() - at) {
+			malformed("offset out of range");
+		}
+	}
+
+	std::span<const std::uint8_t> buf_;
+	std::size_t pos_{};
+	std::size_t vtable_{};
+	std::uint16_t vtable_size_{};
+};
+
+} // namespace fb
+
+// Format constants from Schema.fbs / Message.fbs.
+inline constexpr std::int16_t metadata_v5 = 4;
+inline constexpr std::uint8_t header_schema = 1;
+inline constexpr std::uint8_t header_record_batch = 3;
+inline constexpr std::uint8_t type_utf8 = 5;
+inline constexpr std::uint32_t continuation = 0xFFFFFFFF;
+inline constexpr char magic[6] = { 'A', 'R', 'R', 'O', 'W', '1' };
+
+struct Block {
+	std::int64_t offset;
+	std::int32_t metadata_length;
+	std::int32_t pad;
+	std::int64_t body_length;
+};
+static_assert(sizeof(Block) == 24);
+
+struct BufferDesc {
+	std::int64_t offset;
+	std::int64_t length;
+};
+
+struct FieldNode {
+	std::int64_t length;
+	std::int64_t null_count;
+};
+
+namespace detail {
+
+inline std::size_t align_up(std::size_t v, std::size_t a) {
+	return (v + a - 1) / a * a;
+}
+
+// Schema table with one nullable utf8 field per name.
+inline std::size_t write_schema(fb::Builder &b, std::span<const std::string_view> names) {
+	std::size_t schema_pos[2];
+	const std::size_t schema = b.table({ { 0, 2, 0 /* Little */ }, { 1, 4, 0 } }, schema_pos);
+	const std::size_t fields = b.offset_vector(names.size());
+	b.link(schema_pos[1], fields);
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		// name, nullable, type_type, type, children
+		std::size_t pos[5];
+		const std::size_t field =
+			b.table({ { 0, 4, 0 }, { 1, 1, 1 }, { 2, 1, type_utf8 }, { 3, 4, 0 }, { 5, 4, 0 } }, pos);
+		b.link(fields + 4 + 4 * i, field);
+		b.link(pos[0], b.string(names[i]));
+		b.link(pos[3], b.table({})); // Utf8 has no fields
+		b.link(pos[4], b.offset_vector(0));
+	}
+	return schema;
+}
+
+template<typename T>
+std::span<const std::byte> bytes_of(const std::vector<T> &v) {
+	return std::as_bytes(std::span(v));
+}
+
+// Encapsulated message: continuation marker, metadata size, flatbuffer, padding up to `alignment` in the file.
+inline std::size_t write_message(std::ofstream &out, std::size_t file_offset, const std::vector<std::uint8_t> &fb) {
+	const std::size_t padded = align_up(file_offset + 8 + fb.size(), alignment) - file_offset - 8;
+	const auto size = static_cast<std::int32_t>(padded);
+	out.write(reinterpret_cast<const char *>(&continuation), 4);
+	out.write(reinterpret_cast<const char *>(&size), 4);
+	out.write(reinterpret_cast<const char *>(fb.data()), static_cast<std::streamsize>(fb.size()));
+	static constexpr char zeros[alignment] = {};
+	out.write(zeros, static_cast<std::streamsize>(padded - fb.size()));
+	return 8 + padded;
+}
+
+inline void write_padding(std::ofstream &out, std::size_t bytes) {
+	static constexpr char zeros[alignment] = {};
+	out.write(zeros, static_cast<std::streamsize>(bytes));
+}
+
+} // namespace detail
+
+struct WriteOptions {
+	std::size_t batch_rows = std::size_t{ 1 } << 20;
+};
+
+// Writes named utf8 columns as an Arrow IPC file, one record batch per `batch_rows` rows.
+inline void write_file(const std::filesystem::path &path, std::span<const std::string_view> names,
+					   std::span<const StringColumnView> columns, WriteOptions options = {}) {
+	using detail::align_up;
+	if (names.size() != columns.size()) {
+		throw std::invalid_argument("one name per column");
+	}
+	const std::size_t rows = columns.empty() ? 0 : columns[0].size();
+	for (const auto &c : columns) {
+		if (c.size() != rows) {
+			throw std::invalid_argument("columns differ in length");
+		}
+	}
+	const std::size_t batch_rows = std::max<std::size_t>(options.batch_rows, 1);
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("cannot open " + path.string());
+	}
+	out.write(magic, sizeof(magic));
+	detail::write_padding(out, 2);
+	std::size_t offset = 8;
+
+	{
+		fb::Builder b;
+		std::size_t pos[3];
+		const std::size_t message = b.table({ { 0, 2, metadata_v5 }, { 1, 1, header_schema }, { 2, 4, 0 } }, pos);
+		b.link(pos[2], detail::write_schema(b, names));
+		offset += detail::write_message(out, offset, b.finish(message));
+	}
+
+	std::vector<Block> blocks;
+	std::vector<std::int32_t> rebased;
+	std::vector<std::uint8_t> bitmap;
+	for (std::size_t begin = 0; begin < rows || (rows == 0 && blocks.empty()); begin += batch_rows) {
+		const std::size_t count = std::min(batch_rows, rows - begin);
+
+		// lay out the body: validity (only if there are nulls), offsets, data per column, each 64-byte aligned
+		std::vector<FieldNode> nodes;
+		std::vector<BufferDesc> buffers;
+		std::size_t body = 0;
+		for (const auto &c : columns) {
+			std::size_t nulls = 0;
+			if (c.validity != nullptr) {
+				for (std::size_t i = begin; i < begin + count; ++i) {
+					nulls += !c.is_valid(i);
+				}
+			}
+			const std::size_t data_bytes =
+				count == 0 ? 0 : static_cast<std::size_t>(c.offsets[begin + count] - c.offsets[begin]);
+			nodes.push_back({ static_cast<std::int64_t>(count), static_cast<std::int64_t>(nulls) });
+			for (std::size_t len : { nulls ? (count + 7) / 8 : 0, (count + 1) * 4, data_bytes }) {
+				buffers.push_back({ static_cast<std::int64_t>(body), static_cast<std::int64_t>(len) });
+				body = align_up(body + len, alignment);
+			}
+		}
+
+		fb::Builder b;
+		std::size_t pos[4];
+		const std::size_t message =
+			b.table({ { 0, 2, metadata_v5 }, { 1, 1, header_record_batch }, { 2, 4, 0 }, { 3, 8, body } }, pos);
+		std::size_t batch_pos[3];
+		const std::size_t batch = b.table({ { 0, 8, count }, { 1, 4, 0 }, { 2, 4, 0 } }, batch_pos);
+		b.link(pos[2], batch);
+		b.link(batch_pos[1], b.struct_vector(nodes.size(), 8, detail::bytes_of(nodes)));
+		b.link(batch_pos[2], b.struct_vector(buffers.size(), 8, detail::bytes_of(buffers)));
+
+		const std::size_t metadata = detail::write_message(out, offset, b.finish(message));
+		blocks.push_back({ static_cast<std::int64_t>(offset), static_cast<std::int32_t>(metadata), 0,
+						   static_cast<std::int64_t>(body) });
+		offset += metadata;
+
+		std::size_t written = 0;
+		auto emit = [&](std::size_t buffer, const void *data) {
+			detail::write_padding(out, static_cast<std::size_t>(buffers[buffer].offset) - written);
+			out.write(static_cast<const char *>(data), buffers[buffer].length);
+			written = static_cast<std::size_t>(buffers[buffer].offset + buffers[buffer].length);
+		};
+		for (std::size_t c = 0; c < columns.size(); ++c) {
+			const auto &col = columns[c];
+			if (nodes[c].null_count != 0) {
+				if (begin % 8 == 0) {
+					emit(3 * c, col.validity + begin / 8);
+				}
+				else {
+					// batch starts mid-byte: re-pack its bits so bit 0 is the batch's first row
+					bitmap.assign((count + 7) / 8, 0);
+					for (std::size_t i = 0; i < count; ++i) {
+						bitmap[i / 8] |= static_cast<std::uint8_t>(col.is_valid(begin + i) << (i % 8));
+					}
+					emit(3 * c, bitmap.data());
+				}
+			}
+			rebased.resize(count + 1);
+			for (std::size_t i = 0; i <= count; ++i) {
+				rebased[i] = count == 0 ? 0 : col.offsets[begin + i] - col.offsets[begin];
+			}
+			emit(3 * c + 1, rebased.data());
+			emit(3 * c + 2, count == 0 ? "" : col.data + col.offsets[begin]);
+		}
+		detail::write_padding(out, body - written);
+		offset += body;
+		if (rows == 0) {
+			break;
+		}
+	}
+
+	const std::uint32_t eos[2] = { continuation, 0 };
+	out.write(reinterpret_cast<const char *>(eos), sizeof(eos));
+
+	fb::Builder b;
+	std::size_t pos[4];
+	const std::size_t footer = b.table({ { 0, 2, metadata_v5 }, { 1, 4, 0 }, { 2, 4, 0 }, { 3, 4, 0 } }, pos);
+	b.link(pos[1], detail::write_schema(b, names));
+	b.link(pos[2], b.struct_vector(0, 8, {}));
+	b.link(pos[3], b.struct_vector(blocks.size(), 8, detail::bytes_of(blocks)));
+	auto footer_fb = b.finish(footer);
+	const auto footer_size = static_cast<std::int32_t>(footer_fb.size());
+	out.write(reinterpret_cast<const char *>(footer_fb.data()), footer_size);
+	out.write(reinterpret_cast<const char *>(&footer_size), 4);
+	out.write(magic, sizeof(magic));
+	if (!out) {
+		throw std::runtime_error("write failed: " + path.string());
+	}
+}
+
+// Maps an Arrow IPC file and exposes its utf8 columns in place. Views stay valid while the File lives.
+class File {
+public:
+	static File open(const std::filesystem::path &path) {
+		File f;
+		f.file_ = MappedFile(path);
+		f.parse();
+		return f;
+	}
+
+	std::span<const std::string> column_names() const {
+		return names_;
+	}
+
+	std::size_t batch_count() const {
+		return batches_.size();
+	}
+
+	std::size_t rows() const {
+		return rows_;
+	}
+
+	// Column `column` (schema order) of record batch `batch`. Throws if that column is not utf8.
+	StringColumnView column(std::size_t batch, std::size_t column) const {
+		if (!utf8_[column]) {
+			throw std::runtime_error("column '" + names_[column] + "' is not utf8");
+		}
+		return batches_[batch][column];
+	}
+
+	std::optional<std::size_t> column_index(std::string_view name) const {
+		auto it = std::find(names_.begin(), names_.end(), name);
+		return it == names_.end() ? std::nullopt : std::optional<std::size_t>(it - names_.begin());
+	}
+
+private:
+	void parse() {
+		auto bytes = file_.bytes();
+		std::span<const std::uint8_t> data(reinterpret_cast<const std::uint8_t *>(bytes.data()), bytes.size());
+		if (data.size() < 8 + 10 || std::memcmp(data.data(), magic, 6) != 0 ||
+			std::memcmp(data.data() + data.size() - 6, magic, 6) != 0) {
+			fb::malformed("missing ARROW1 magic");
+		}
+		std::int32_t footer_size;
+		std::memcpy(&footer_size, data.data() + data.size() - 10, 4);
+		if (footer_size <= 0 || static_cast<std::size_t>(footer_size) > data.size() - 18) {
+			fb::malformed("bad footer size");
+		}
+		auto footer = fb::Table::root(data.subspan(data.size() - 10 - footer_size, footer_size));
+
+		auto schema = footer.table(1);
+		if (!schema) {
+			fb::malformed("footer has no schema");
+		}
+		auto [fields, field_count] = schema->vector(1, 4);
+		for (std::size_t i = 0; i < field_count; ++i) {
+			auto field = schema->table_at(fields + 4 * i);
+			names_.emplace_back(field.string(0));
+			const auto type = field.scalar<std::uint8_t>(2);
+			const bool dictionary = field.table(4).has_value();
+			utf8_.push_back(type == type_utf8 && !dictionary);
+			buffer_counts_.push_back(dictionary ? 2 : buffers_for_type(type));
+			if (buffer_counts_.back() < 0 || field.vector(5, 4).second != 0) {
+				// nested columns add child nodes/buffers we would have to walk to find the next column
+				throw std::runtime_error("Arrow column '" + names_.back() + "' has an unsupported (nested) type");
+			}
+		}
+
+		auto [blocks, block_count] = footer.vector(3, sizeof(Block));
+		for (std::size_t i = 0; i < block_count; ++i) {
+			Block block{};
+			block.offset = footer.read<std::int64_t>(blocks + sizeof(Block) * i);
+			block.metadata_length = footer.read<std::int32_t>(blocks + sizeof(Block) * i + 8);
+			block.body_length = footer.read<std::int64_t>(blocks + sizeof(Block) * i + 16);
+			parse_batch(data, block);
+		}
+	}
+
+	// Buffers per column of a flat (non-nested) Type union member; -1 for nested or unknown types.
+	static int buffers_for_type(std::uint8_t type) {
+		switch (type) {
+		case 1: // Null
+			return 0;
+		case 4:  // Binary
+		case 5:  // Utf8
+		case 19: // LargeBinary
+		case 20: // LargeUtf8
+			return 3;
+		case 2:  // Int
+		case 3:  // FloatingPoint
+		case 6:  // Bool
+		case 7:  // Decimal
+		case 8:  // Date
+		case 9:  // Time
+		case 10: // Timestamp
+		case 11: // Interval
+		case 15: // FixedSizeBinary
+		case 18: // Duration
+			return 2;
+		default:
+			return -1;
+		}
+	}
+
+	void parse_batch(std::span<const std::uint8_t> data, const Block &block) {
+		auto in_file = [&](std::int64_t at, std::int64_t len) {
+			return at >= 0 && len >= 0 && static_cast<std::uint64_t>(at) <= data.size() &&
+				   static_cast<std::uint64_t>(len) <= data.size() - static_cast<std::uint64_t>(at);
+		};
+		if (!in_file(block.offset, block.metadata_length) ||
+			!in_file(block.offset + block.metadata_length, block.body_length) || block.metadata_length < 8) {
+			fb::malformed("record batch block out of range");
+		}
+		auto meta =
+			data.subspan(static_cast<std::size_t>(block.offset), static_cast<std::size_t>(block.metadata_length));
+		std::uint32_t first;
+		std::memcpy(&first, meta.data(), 4);
+		const std::size_t skip = first == continuation ? 8 : 4; // pre-1.0 files have no continuation marker
+
+		auto message = fb::Table::root(meta.subspan(skip));
+		auto header = message.table(2);
+		if (message.scalar<std::uint8_t>(1) != header_record_batch || !header) {
+			fb::malformed("block is not a record batch");
+		}
+		if (header->table(3)) {
+			throw std::runtime_error("compressed Arrow record batches are not supported");
+		}
+		const auto length = header->scalar<std::int64_t>(0);
+		auto [nodes, node_count] = header->vector(1, sizeof(FieldNode));
+		auto [buffers, buffer_count] = header->vector(2, sizeof(BufferDesc));
+		std::vector<std::size_t> first_buffer(names_.size() + 1, 0);
+		for (std::size_t c = 0; c < names_.size(); ++c) {
+			first_buffer[c + 1] = first_buffer[c] + static_cast<std::size_t>(buffer_counts_[c]);
+		}
+		if (node_count != names_.size() || buffer_count < first_buffer.back() || length < 0) {
+			fb::malformed("record batch does not match schema");
+		}
+
+		const std::uint8_t *body = data.data() + block.offset + block.metadata_length;
+		auto buffer = [&](std::size_t i) {
+			BufferDesc d { header->read<std::int64_t>(buffers + 16 * i),
+						   header->read<std::int64_t>(buffers + 16 * i + 8) };
+			if (d.offset < 0 || d.length < 0 || d.offset > block.body_length ||
+				d.length > block.body_length - d.offset) {
+				fb::malformed("buffer out of range");
+			}
+			return d;
+		};
+
+		std::vector<StringColumnView> columns(names_.size());
+		for (std::size_t c = 0; c < names_.size(); ++c) {
+			if (!utf8_[c]) {
+				continue; // other flat columns are skipped over, only utf8 is exposed
+			}
+			auto node_length = header->read<std::int64_t>(nodes + 16 * c);
+			auto nulls = header->read<std::int64_t>(nodes + 16 * c + 8);
+			const std::size_t b = first_buffer[c];
+			auto validity = buffer(b), offsets = buffer(b + 1), values = buffer(b + 2);
+			const auto n = static_cast<std::size_t>(node_length);
+			if (node_length != length || offsets.length < static_cast<std::int64_t>((n + 1) * 4) ||
+				(nulls > 0 && validity.length < static_cast<std::int64_t>((n + 7) / 8)) ||
+				reinterpret_cast<std::uintptr_t>(body + offsets.offset) % alignof(std::int32_t) != 0) {
+				fb::malformed("utf8 column buffers do not match its length");
+			}
+			StringColumnView view;
+			view.validity = nulls > 0 ? body + validity.offset : nullptr;
+			view.offsets = reinterpret_cast<const std::int32_t *>(body + offsets.offset);
+			view.data = reinterpret_cast<const char *>(body + values.offset);
+			view.length = n;
+			view.null_count = static_cast<std::size_t>(nulls);
+			// only the ends are checked; the file is otherwise trusted to have monotonic offsets
+			if (n > 0 &&
+				(view.offsets[0] < 0 || view.offsets[n] < view.offsets[0] || view.offsets[n] > values.length)) {
+				fb::malformed("utf8 offsets out of range");
+			}
+			columns[c] = view;
+		}
+		rows_ += static_cast<std::size_t>(length);
+		batches_.push_back(std::move(columns));
+	}
+
+	File() = default;
+
+	MappedFile file_;
+	std::vector<std::string> names_;
+	std::vector<bool> utf8_;
+	std::vector<int> buffer_counts_;
+	std::vector<std::vector<StringColumnView>> batches_;
+	std::size_t rows_{};
+};
+
+} // namespace arrow_ipc
+
+//================================
+// 			USER ARROW FILES
+//================================
+inline void write_users_arrow(const std::filesystem::path &path, const UserColumnsView &users,
+							  arrow_ipc::WriteOptions options = {}) {
+	const std::string_view names[] = { "username", "email" };
+	const StringColumnView columns[] = { users.username, users.email };
+	arrow_ipc::write_file(path, names, columns, options);
+}
+
+template<std::ranges::input_range R>
+	requires UserTypeConcept<std::ranges::range_value_t<R>>
+void write_users_arrow(const std::filesystem::path &path, R &&users, arrow_ipc::WriteOptions options = {}) {
+	write_users_arrow(path, UserColumns::from(std::forward<R>(users)).view(), options);
+}
+
+// Zero-copy user table: one UserColumnsView per record batch, pointing into the mapped file.
+class UserArrowFile {
+public:
+	static UserArrowFile open(const std::filesystem::path &path) {
+		UserArrowFile users;
+		users.file_ = arrow_ipc::File::open(path);
+		auto username = users.file_->column_index("username");
+		auto email = users.file_->column_index("email");
+		if (!username || !email) {
+			throw std::runtime_error(path.string() + " has no username/email columns");
+		}
+		for (std::size_t b = 0; b < users.file_->batch_count(); ++b) {
+			users.batches_.push_back({ users.file_->column(b, *username), users.file_->column(b, *email) });
+		}
+		return users;
+	}
+
+	std::size_t rows() const {
+		return file_->rows();
+	}
+
+	std::span<const UserColumnsView> batches() const {
+		return batches_;
+	}
+
+	template<UserTypeConcept T = User>
+	std::vector<T> to_records() const {
+		std::vector<T> records;
+		records.reserve(rows());
+		for (const auto &batch : batches_) {
+			for (std::size_t i = 0; i < batch.size(); ++i) {
+				records.push_back(user_at<T>(batch, i));
+			}
+		}
+		return records;
+	}
+
+private:
+	std::optional<arrow_ipc::File> file_;
+	std::vector<UserColumnsView> batches_;
+};
@@ -0,0 +1,827 @@
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "bench_stats.hpp"
+#include "device_farm.hpp"
+#include "digital_input.hpp"
+#include "kd_tree.hpp"
+#include "memory_footprint.hpp"
+#include "morton.hpp"
+#include "pairwise_distance.hpp"
+#include "quaternion.hpp"
+#include "radix_sort.hpp"
+#include "roaring_bitmap.hpp"
+#include "sharded_counters.hpp"
+#include "simd_sort.hpp"
+#include "sorted_set.hpp"
+#include "startup_profile.hpp"
+#include "string_hash.hpp"
+#include "summation.hpp"
+#include "user.hpp"
+#include "user_columns.hpp"
+#include "user_query.hpp"
+#include "vec3.hpp"
+#include "voxel_grid.hpp"
+
+// Benchmark driver. Results go to JSON so runs from different commits can be compared statistically:
+//
+//     cmake_project_template_bench --label $(git rev-parse --short HEAD) --out new.json
+//     cmake_project_template_bench --compare base.json new.json [--threshold 0.05] [--alpha 0.01]
+//     cmake_project_template_bench --farm [--devices 1000,1000000] [--threads 1,4] [--button]
+//     cmake_project_template_bench --memory [--elements 1000,1000000]
+//     cmake_project_template_bench --scale [--elements 65536,1048576] [--threads 1,2,4] [--filter user] [--out s.json]
+//     cmake_project_template_bench --startup [--config farm.conf] [--out startup.json]
+//
+// --compare exits with 1 when any benchmark got significantly slower, so it can gate CI.
+
+struct Benchmark {
+	std::string name;
+	std::function<void(std::size_t)> run;
+};
+
+//================================
+// 			HEAP HOOKS
+//================================
+// Replacement operator new / delete feeding heap_stats (memory_footprint.hpp). Every block carries its size in a
+// prefix, so unsized deletes are counted too; array and nothrow forms forward to these by default.
+namespace heap_hooks {
+
+constexpr std::size_t prefix_for(std::size_t align) {
+	return std::max(align, alignof(std::max_align_t));
+}
+
+void *allocate(std::size_t size, std::size_t align) {
+	const std::size_t prefix = prefix_for(align);
+	void *base = align <= alignof(std::max_align_t)
+					 ? std::malloc(prefix + size)
+					 : std::aligned_alloc(align, (prefix + size + align - 1) / align * align);
+	if (base == nullptr) {
+		throw std::bad_alloc();
+	}
+	auto *user = static_cast<std::byte *>(base) + prefix;
+	std::memcpy(user - sizeof(std::size_t), &size, sizeof(std::size_t));
+	heap_stats::on_alloc(size);
+	return user;
+}
+
+void deallocate(void *p, std::size_t align) noexcept {
+	if (p == nullptr) {
+		return;
+	}
+	auto *user = static_cast<std::byte *>(p);
+	std::size_t size;
+	std::memcpy(&size, user - sizeof(std::size_t), sizeof(std::size_t));
+	heap_stats::on_free(size);
+	std::free(user - prefix_for(align));
+}
+
+[[maybe_unused]] const bool installed = (heap_stats::installed = true);
+
+} // namespace heap_hooks
+
+void *operator new(std::size_t size) {
+	return heap_hooks::allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+	return heap_hooks::allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p) noexcept {
+	heap_hooks::deallocate(p, alignof(std::max_align_t));
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	heap_hooks::deallocate(p, alignof(std::max_align_t));
+}
+
+void operator delete(void *p, std::align_val_t align) noexcept {
+	heap_hooks::deallocate(p, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t align) noexcept {
+	heap_hooks::deallocate(p, static_cast<std::size_t>(align));
+}
+
+//================================
+// 			DATA
+//================================
+std::vector<Vec3> random_points(std::size_t n, float extent = 100.0f) {
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> coord(0.0f, extent);
+	std::vector<Vec3> points(n);
+	for (auto &p : points) {
+		p = { .e0 = coord(rng), .e1 = coord(rng), .e2 = coord(rng) };
+	}
+	return points;
+}
+
+// Same rows as random_users(n), appended straight into columns so large tables don't need a row copy.
+UserColumns random_user_columns(std::size_t n) {
+	std::mt19937 rng(7);
+	const char *domains[] = { "example.com", "corp.example", "navy.mil", "kernel.org" };
+	UserColumns columns;
+	User user;
+	for (std::size_t i = 0; i < n; ++i) {
+		user.username = "user" + std::to_string(rng() % (n * 4));
+		user.email = user.username + "@" + domains[rng() % 4];
+		columns.append(user);
+	}
+	return columns;
+}
+
+std::vector<User> random_users(std::size_t n) {
+	std::mt19937 rng(7);
+	const char *domains[] = { "example.com", "corp.example", "navy.mil", "kernel.org" };
+	std::vector<User> users(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		users[i].username = "user" + std::to_string(rng() % (n * 4));
+		users[i].email = users[i].username + "@" + domains[rng() % 4];
+	}
+	return users;
+}
+
+//================================
+// 			BUTTONS
+//================================
+// ButtonWithConcept and ButtonWithSfinae differ only in how the template is constrained; these should tie.
+template<typename Button>
+Benchmark button_benchmark(std::string name) {
+	return { std::move(name), [](std::size_t iterations) {
+				MockedDigitalInput input;
+				Button button(&input);
+				button.init();
+				long long sum = 0;
+				for (std::size_t i = 0; i < iterations; ++i) {
+					input.set_value(static_cast<int>(i));
+					sum += button.read();
+					do_not_optimize(sum);
+				}
+			} };
+}
+
+//================================
+// 			KERNELS
+//================================
+std::vector<Benchmark> kernel_benchmarks() {
+	std::vector<Benchmark> out;
+	auto points = std::make_shared<const std::vector<Vec3>>(random_points(100'000));
+
+	out.push_back({ "morton_order/100k", [points](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(morton_order(*points).back());
+					   }
+				   } });
+	out.push_back({ "voxel_downsample/100k", [points](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(voxel_downsample(*points, { .leaf_size = 2.0f }).size());
+					   }
+				   } });
+	out.push_back({ "kd_tree_build/100k", [points](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   KdTree tree(*points);
+						   do_not_optimize(tree);
+					   }
+				   } });
+	auto tree = std::make_shared<const KdTree>(*points);
+	auto queries = std::make_shared<const std::vector<Vec3>>(random_points(10'000));
+	out.push_back({ "kd_tree_nearest/10k", [tree, queries](std::size_t iterations) {
+					   std::vector<KdTree::Neighbor> found(queries->size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   tree->nearest_batch(*queries, found);
+						   do_not_optimize(found.back());
+					   }
+				   } });
+	out.push_back({ "pairwise_sq_distances/1kx1k", [points](std::size_t iterations) {
+					   std::span<const Vec3> a(points->data(), 1000), b(points->data() + 1000, 1000);
+					   std::vector<float> d(a.size() * b.size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   pairwise_sq_distances(a, b, d);
+						   do_not_optimize(d.back());
+					   }
+				   } });
+	out.push_back({ "rotate_points/100k", [points](std::size_t iterations) {
+					   std::vector<Vec3> work = *points;
+					   const Quat q = Quat::from_axis_angle({ .e0 = 0, .e1 = 0, .e2 = 1 }, 0.01f);
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   rotate_points(q, std::span(work));
+						   do_not_optimize(work.back());
+					   }
+				   } });
+	out.push_back({ "radix_sort_pairs/1M", [](std::size_t iterations) {
+					   std::mt19937_64 rng(1);
+					   std::vector<std::uint64_t> source(1'000'000);
+					   for (auto &k : source) {
+						   k = rng();
+					   }
+					   std::vector<std::uint64_t> keys;
+					   std::vector<std::uint32_t> values(source.size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   keys = source;
+						   std::iota(values.begin(), values.end(), 0u);
+						   radix_sort_pairs(std::span(keys), std::span(values));
+						   do_not_optimize(keys.front());
+					   }
+				   } });
+	auto ids = std::make_shared<const std::vector<std::uint32_t>>([] {
+		std::mt19937 rng(2);
+		std::vector<std::uint32_t> v(1'000'000);
+		for (auto &k : v) {
+			k = rng();
+		}
+		return v;
+	}());
+	out.push_back({ "std_sort_u32/1M", [ids](std::size_t iterations) {
+					   std::vector<std::uint32_t> keys;
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   keys = *ids;
+						   std::ranges::sort(keys);
+						   do_not_optimize(keys.front());
+					   }
+				   } });
+	out.push_back({ "simd_sort_u32/1M", [ids](std::size_t iterations) {
+					   std::vector<std::uint32_t> keys;
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   keys = *ids;
+						   simd_sort(std::span(keys));
+						   do_not_optimize(keys.front());
+					   }
+				   } });
+	out.push_back({ "simd_sort_pairs_u32/1M", [ids](std::size_t iterations) {
+					   std::vector<std::uint32_t> keys, values(ids->size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   keys = *ids;
+						   std::iota(values.begin(), values.end(), 0u);
+						   simd_sort_pairs(std::span(keys), std::span(values));
+						   do_not_optimize(keys.front());
+					   }
+				   } });
+	// id lists as two half-dense filters over 2M rows would give them, plus a 1000-id one
+	auto id_lists = std::make_shared<const std::array<std::vector<std::uint32_t>, 3>>([] {
+		std::mt19937 rng(4);
+		std::array<std::vector<std::uint32_t>, 3> lists;
+		for (std::uint32_t row = 0; row < 2'000'000; ++row) {
+			for (std::size_t l = 0; l < 2; ++l) {
+				if (rng() % 2 == 0) {
+					lists[l].push_back(row);
+				}
+			}
+			if (rng() % 2000 == 0) {
+				lists[2].push_back(row);
+			}
+		}
+		return lists;
+	}());
+	out.push_back({ "sorted_intersection/1Mx1M", [id_lists](std::size_t iterations) {
+					   const auto &[a, b, small] = *id_lists;
+					   std::vector<std::uint32_t> out(std::min(a.size(), b.size()));
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(sorted_intersection<std::uint32_t>(a, b, out));
+					   }
+				   } });
+	out.push_back({ "sorted_union/1Mx1M", [id_lists](std::size_t iterations) {
+					   const auto &[a, b, small] = *id_lists;
+					   std::vector<std::uint32_t> out(a.size() + b.size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(sorted_union<std::uint32_t>(a, b, out));
+					   }
+				   } });
+	out.push_back({ "sorted_intersection/1kx1M", [id_lists](std::size_t iterations) {
+					   const auto &[a, b, small] = *id_lists;
+					   std::vector<std::uint32_t> out(small.size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(sorted_intersection<std::uint32_t>(small, a, out));
+					   }
+				   } });
+	// the same id lists as selections: dense bitmap words against roaring containers
+	auto selections = std::make_shared<const std::array<RoaringBitmap, 3>>(std::array<RoaringBitmap, 3> {
+		RoaringBitmap::from_sorted((*id_lists)[0]), RoaringBitmap::from_sorted((*id_lists)[1]),
+		RoaringBitmap::from_sorted((*id_lists)[2]) });
+	out.push_back({ "roaring_and/1Mx1M", [selections](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize((*selections)[0] & (*selections)[1]);
+					   }
+				   } });
+	out.push_back({ "roaring_and/1kx1M", [selections](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize((*selections)[2] & (*selections)[0]);
+					   }
+				   } });
+	out.push_back({ "roaring_for_each/1M", [selections](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   std::uint64_t sum = 0;
+						   (*selections)[0].for_each([&sum](std::uint32_t row) { sum += row; });
+						   do_not_optimize(sum);
+					   }
+				   } });
+	auto components = std::make_shared<const std::vector<float>>(
+		reinterpret_cast<const float *>(points->data()), reinterpret_cast<const float *>(points->data()) + 300'000);
+	out.push_back({ "sum_naive/300k", [components](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(std::accumulate(components->begin(), components->end(), 0.0f));
+					   }
+				   } });
+	out.push_back({ "sum_pairwise/300k", [components](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(pairwise_sum(*components));
+					   }
+				   } });
+	out.push_back({ "sum_neumaier/300k", [components](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(neumaier_sum(*components));
+					   }
+				   } });
+	out.push_back({ "centroid/100k", [points](std::size_t iterations) {
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(centroid(*points));
+					   }
+				   } });
+	return out;
+}
+
+//================================
+// 			USERS
+//================================
+std::vector<Benchmark> user_benchmarks() {
+	std::vector<Benchmark> out;
+	auto users = std::make_shared<const std::vector<User>>(random_users(100'000));
+	auto table = std::make_shared<const UserColumns>(UserColumns::from(*users));
+
+	out.push_back({ "string_hash_column/100k", [table](std::size_t iterations) {
+					   std::vector<std::uint64_t> hashes(table->size());
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   string_hash::hash_column(table->view().email, hashes);
+						   do_not_optimize(hashes.back());
+					   }
+				   } });
+	out.push_back({ "user_filter/100k", [table](std::size_t iterations) {
+					   using namespace user_query;
+					   const auto predicate = email.domain_in({ "corp.example" }) && !username.starts_with("user1");
+					   for (std::size_t i = 0; i < iterations; ++i) {
+						   do_not_optimize(filter(table->view(), predicate).count());
+					   }
+				   } });
+	return out;
+}
+
+//================================
+// 			DEVICE FARM
+//================================
+std::vector<std::size_t> parse_list(const std::string &csv) {
+	std::vector<std::size_t> out;
+	for (std::size_t at = 0; at < csv.size();) {
+		const std::size_t comma = std::min(csv.find(',', at), csv.size());
+		out.push_back(std::stoul(csv.substr(at, comma - at)));
+		at = comma + 1;
+	}
+	return out;
+}
+
+// 1, 2, 4, .. and the core count.
+std::vector<std::size_t> default_thread_counts() {
+	std::vector<std::size_t> counts;
+	for (std::size_t t = 1; t < std::thread::hardware_concurrency(); t *= 2) {
+		counts.push_back(t);
+	}
+	counts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+	return counts;
+}
+
+// Throughput and simulated event latency for every (devices, threads) pair.
+int farm_sweep(std::vector<std::size_t> device_counts, std::vector<std::size_t> thread_counts, PollPath path) {
+	if (device_counts.empty()) {
+		device_counts = { 1'000, 10'000, 100'000, 1'000'000 };
+	}
+	if (thread_counts.empty()) {
+		thread_counts = default_thread_counts();
+	}
+	std::println("{:>10} {:>7} {:>14} {:>12} {:>9} {:>9} {:>9} {:>9}", "devices", "threads", "reads/s", "events/s",
+				 "p50 us", "p99 us", "max us", "spurious");
+	for (auto devices : device_counts) {
+		for (auto threads : thread_counts) {
+			DeviceFarm farm({ .devices = devices });
+			// about 20M reads per cell, at least 50 rounds
+			const std::size_t rounds = std::max<std::size_t>(50, 20'000'000 / devices);
+			const auto r = run_farm_load(farm, { .threads = threads, .rounds = rounds, .path = path });
+			std::println("{:>10} {:>7} {:>14.3e} {:>12.3e} {:>9} {:>9} {:>9} {:>9}", devices, r.threads,
+						 r.reads_per_second(), r.events_per_second(), r.latency.quantile(0.5),
+						 r.latency.quantile(0.99), r.latency.max(), r.spurious_events);
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+//================================
+// 			SCALABILITY
+//================================
+// Every parallel kernel at 1, 2, 4 .. N threads and several sizes. The kernels run unmodified under a
+// ThreadPool::Scope of the given size. Bandwidth is the least traffic a kernel needs per element over its time,
+// next to a STREAM triad at the same size and thread count: a kernel that tracks the triad is memory bound, one
+// that stops scaling well below it is limited by something else (serial sections, contention, imbalance).
+struct ScaleCase {
+	std::function<void()> run;
+	double bytes_per_element;
+};
+
+struct ScaleWorkload {
+	std::string name;
+	std::function<ScaleCase(std::size_t)> prepare; // builds the inputs for n elements
+};
+
+std::vector<ScaleWorkload> scale_workloads() {
+	std::vector<ScaleWorkload> out;
+	// a[i] = b[i] + 3 c[i]; STREAM counts 24 bytes per element (two reads, one write)
+	out.push_back({ "stream_triad", [](std::size_t n) {
+					   auto a = std::make_shared<std::vector<double>>(n, 0.0);
+					   auto b = std::make_shared<std::vector<double>>(n, 1.0);
+					   auto c = std::make_shared<std::vector<double>>(n, 2.0);
+					   return ScaleCase{ [a, b, c] {
+											parallel_for(a->size(), 64 * 1024, [&](std::size_t lo, std::size_t hi) {
+												for (std::size_t i = lo; i < hi; ++i) {
+													(*a)[i] = (*b)[i] + 3.0 * (*c)[i];
+												}
+											});
+											do_not_optimize(a->back());
+										},
+										 3 * sizeof(double) };
+				   } });
+	out.push_back({ "reduce_bounds", [](std::size_t n) {
+					   auto points = std::make_shared<const std::vector<Vec3>>(random_points(n));
+					   return ScaleCase{ [points] { do_not_optimize(compute_bounds(*points)); }, sizeof(Vec3) };
+				   } });
+	out.push_back({ "transform_vec3", [](std::size_t n) {
+					   auto points = std::make_shared<std::vector<Vec3>>(random_points(n));
+					   const Affine3 a = Quat::from_axis_angle({ .e0 = 0, .e1 = 0, .e2 = 1 }, 0.01f).to_affine();
+					   return ScaleCase{ [points, a] {
+											transform_points(a, std::span(*points));
+											do_not_optimize(points->back());
+										},
+										 2 * sizeof(Vec3) };
+				   } });
+	out.push_back({ "user_filter", [](std::size_t n) {
+					   auto table = std::make_shared<const UserColumns>(random_user_columns(n));
+					   const auto view = table->view();
+					   const double column_bytes = static_cast<double>(
+						   view.username.data_bytes() + view.email.data_bytes() + 2 * (n + 1) * sizeof(std::int32_t));
+					   return ScaleCase{ [table] {
+											using namespace user_query;
+											const auto predicate = email.domain_in({ "corp.example" }) &&
+																   !username.starts_with("user1");
+											do_not_optimize(filter(table->view(), predicate).count());
+										},
+										 // + one selection bit written per row
+										 column_bytes / static_cast<double>(std::max<std::size_t>(n, 1)) + 0.125 };
+				   } });
+	// one poll round of n devices; per device: RNG state read + written, level, two toggle times, debounce state
+	out.push_back({ "farm_poll", [](std::size_t n) {
+					   auto farm = std::make_shared<DeviceFarm>(DeviceFarmConfig{ .devices = n });
+					   return ScaleCase{ [farm] {
+											do_not_optimize(run_farm_load(*farm, { .threads = 0, .rounds = 1 }).events);
+										},
+										 2 * sizeof(std::uint64_t) + 1 + 2 * sizeof(std::uint32_t) + 2 * 2 };
+				   } });
+	// n increments spread over 1024 counters: one shared atomic array against per-thread shards
+	out.push_back({ "counters_atomic", [](std::size_t n) {
+					   auto counters = std::make_shared<std::vector<std::atomic<std::int64_t>>>(1024);
+					   return ScaleCase{ [counters, n] {
+											parallel_for(n, 16 * 1024, [&](std::size_t b, std::size_t e) {
+												for (std::size_t i = b; i < e; ++i) {
+													(*counters)[i & 1023].fetch_add(1, std::memory_order_relaxed);
+												}
+											});
+										},
+										 sizeof(std::int64_t) };
+				   } });
+	out.push_back({ "counters_sharded", [](std::size_t n) {
+					   auto counters = std::make_shared<ShardedCounters<std::int64_t>>(1024);
+					   return ScaleCase{ [counters, n] {
+											parallel_for(n, 16 * 1024, [&](std::size_t b, std::size_t e) {
+												for (std::size_t i = b; i < e; ++i) {
+													counters->add(i & 1023);
+												}
+											});
+										},
+										 sizeof(std::int64_t) };
+				   } });
+	return out;
+}
+
+// Appends one result per (workload, size, threads) to `run`, named scale/<workload>/<size>/t<threads>. Thread
+// counts run in increasing order, and one thread is always measured first: it is the baseline of the speedup and
+// efficiency columns.
+void scale_report(std::vector<std::size_t> sizes, std::vector<std::size_t> thread_counts, const std::string &filter,
+				  BenchOptions options, BenchRun &run) {
+	if (sizes.empty()) {
+		sizes = { std::size_t{ 1 } << 16, std::size_t{ 1 } << 20, std::size_t{ 1 } << 23 };
+	}
+	if (thread_counts.empty()) {
+		thread_counts = default_thread_counts();
+	}
+	thread_counts.push_back(1);
+	std::ranges::sort(thread_counts);
+	thread_counts.erase(std::ranges::unique(thread_counts).begin(), thread_counts.end());
+	std::map<std::pair<std::size_t, std::size_t>, double> triad_gbs; // (size, threads) -> GB/s
+	std::println("{:<16} {:>10} {:>7} {:>12} {:>8} {:>10} {:>8} {:>8}", "workload", "elements", "threads", "ns/op",
+				 "speedup", "efficiency", "GB/s", "% triad");
+	for (const auto &workload : scale_workloads()) {
+		if (workload.name != "stream_triad" && !filter.empty() && workload.name.find(filter) == std::string::npos) {
+			continue;
+		}
+		for (auto n : sizes) {
+			const ScaleCase c = workload.prepare(n);
+			double serial_ns = 0;
+			for (auto threads : thread_counts) {
+				ThreadPool pool(threads);
+				ThreadPool::Scope scope(pool);
+				const std::string name =
+					"scale/" + workload.name + "/" + std::to_string(n) + "/t" + std::to_string(threads);
+				run.results.push_back(measure(name, [&](std::size_t iterations) {
+					for (std::size_t i = 0; i < iterations; ++i) {
+						c.run();
+					}
+				}, options));
+				const double ns = bench_stats::median(run.results.back().ns_per_op);
+				if (threads == 1) {
+					serial_ns = ns;
+				}
+				const double speedup = serial_ns / ns;
+				const double gbs = c.bytes_per_element * static_cast<double>(n) / ns; // bytes per ns == GB/s
+				if (workload.name == "stream_triad") {
+					triad_gbs[{ n, threads }] = gbs;
+				}
+				const auto triad = triad_gbs.find({ n, threads });
+				std::println("{:<16} {:>10} {:>7} {:>12.0f} {:>8.2f} {:>9.0f}% {:>8.2f} {:>7.0f}%", workload.name, n,
+							 threads, ns, speedup, 100 * speedup / static_cast<double>(threads), gbs,
+							 triad == triad_gbs.end() ? 0.0 : 100 * gbs / triad->second);
+			}
+		}
+	}
+}
+
+//================================
+// 			MEMORY
+//================================
+// Bytes per element of the populations that bound how many devices / users one process can hold. A button only
+// points at its input, so a button population carries its inputs too.
+template<typename Button>
+struct ButtonPopulation {
+	std::vector<MockedDigitalInput> inputs;
+	std::vector<Button> buttons;
+
+	explicit ButtonPopulation(std::size_t n) : inputs(n) {
+		buttons.reserve(n);
+		for (auto &input : inputs) {
+			buttons.emplace_back(&input).init();
+		}
+	}
+};
+
+int memory_report(std::vector<std::size_t> element_counts) {
+	if (element_counts.empty()) {
+		element_counts = { 1'000'000 };
+	}
+	using ConceptButtons = ButtonPopulation<ButtonWithConcept<MockedDigitalInput>>;
+	using SfinaeButtons = ButtonPopulation<ButtonWithSfinae<MockedDigitalInput>>;
+	constexpr std::size_t button_size = sizeof(MockedDigitalInput) + sizeof(ButtonWithConcept<MockedDigitalInput>);
+	constexpr std::size_t farm_size = sizeof(std::uint64_t) + 1 + 2 * sizeof(std::uint32_t) + 2; // + debouncer
+
+	std::println("{:<16} {:>10} {:>7} {:>10} {:>10} {:>9} {:>10} {:>12}", "population", "elements", "sizeof",
+				 "heap B/el", "peak B/el", "allocs/el", "rss B/el", "heap MiB");
+	for (auto n : element_counts) {
+		const FootprintResult results[] = {
+			measure_footprint("button_concept", n, button_size, [](std::size_t k) { return ConceptButtons(k); }),
+			measure_footprint("button_sfinae", n, button_size, [](std::size_t k) { return SfinaeButtons(k); }),
+			measure_footprint("device_farm", n, farm_size,
+							  [](std::size_t k) {
+								  return std::pair<DeviceFarm, Debouncer>(DeviceFarm({ .devices = k }), Debouncer(k));
+							  }),
+			measure_footprint("user", n, sizeof(User), [](std::size_t k) { return random_users(k); }),
+			measure_footprint("user_columns", n, 2 * sizeof(std::int32_t),
+							  [](std::size_t k) { return UserColumns::from(random_users(k)); }),
+			measure_footprint("vec3", n, sizeof(Vec3), [](std::size_t k) { return std::vector<Vec3>(k); }),
+			measure_footprint("vec3_soa", n, sizeof(Vec3),
+							  [](std::size_t k) {
+								  Vec3SoA soa;
+								  soa.resize(k);
+								  return soa;
+							  }),
+		};
+		for (const auto &r : results) {
+			std::println("{:<16} {:>10} {:>7} {:>10.1f} {:>10.1f} {:>9.3f} {:>10.1f} {:>12.1f}", r.name, r.elements,
+						 r.element_size, r.heap_per_element(), r.peak_heap_per_element(),
+						 static_cast<double>(r.allocations) / static_cast<double>(std::max<std::size_t>(r.elements, 1)),
+						 r.rss_per_element(), static_cast<double>(r.heap_bytes) / (1024.0 * 1024.0));
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+//================================
+// 			STARTUP
+//================================
+// Process start to the first poll of a farm-backed service: config, device creation, init() and the first poll,
+// after the loader and static-init phases the profile recorded at main entry.
+int startup_report(StartupProfile &profile, const std::string &config_path, const std::string &out_path) {
+	const DeviceFarmConfig config = profile.phase("config_load", [&] {
+		return config_path.empty() ? DeviceFarmConfig{} : load_device_farm_config(config_path);
+	});
+	DeviceFarm farm = profile.phase("device_create", [&] { return DeviceFarm(config); });
+	std::vector<DeviceFarm::Input> inputs;
+	std::vector<std::uint8_t> levels;
+	profile.phase("device_handles", [&] {
+		inputs.reserve(farm.size());
+		for (std::size_t i = 0; i < farm.size(); ++i) {
+			inputs.push_back(farm.input(i));
+		}
+		levels.resize(farm.size());
+	});
+	profile_device_startup(profile, std::span(inputs), std::span(levels));
+	do_not_optimize(levels.back());
+
+	const StartupReport report = profile.report();
+	auto ms = [](std::chrono::nanoseconds d) { return std::chrono::duration<double, std::milli>(d).count(); };
+	std::println("{} devices, origin {}", farm.size(),
+				 report.process_start_known ? "process start" : "first static constructor");
+	std::println("{:<16} {:>10} {:>12} {:>7}", "phase", "start ms", "duration ms", "share");
+	for (const auto &p : report.phases) {
+		std::println("{:<16} {:>10.3f} {:>12.3f} {:>6.1f}%", p.name, ms(p.start), ms(p.duration),
+					 100 * ms(p.duration) / std::max(ms(report.total), 1e-9));
+	}
+	std::println("{:<16} {:>10} {:>12.3f} {:>6.1f}%", "unattributed", "", ms(report.unattributed()),
+				 100 * ms(report.unattributed()) / std::max(ms(report.total), 1e-9));
+	std::println("{:<16} {:>10} {:>12.3f}", "total", "", ms(report.total));
+	if (!out_path.empty()) {
+		std::ofstream out(out_path);
+		out << to_json(report);
+		if (!out) {
+			throw std::runtime_error("cannot write " + out_path);
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+//================================
+// 			MAIN
+//================================
+int compare_files(const std::string &base_path, const std::string &current_path, bench_stats::CompareOptions options) {
+	const BenchRun base = load_bench_run(base_path), current = load_bench_run(current_path);
+	if (base.environment.cpu != current.environment.cpu || base.environment.build != current.environment.build) {
+		std::println("warning: runs differ in cpu or build ({} / {} vs {} / {})", base.environment.cpu,
+					 base.environment.build, current.environment.cpu, current.environment.build);
+	}
+	std::println("{:<32} {:>12} {:>12} {:>8} {:>17} {:>9}  {}", "benchmark", "base ns", "current ns", "ratio",
+				 "95% CI", "p", "verdict");
+	int slower = 0;
+	for (const auto &c : bench_stats::compare(base, current, options)) {
+		std::println("{:<32} {:>12.1f} {:>12.1f} {:>8.3f} [{:>6.3f}, {:>6.3f}] {:>9.2g}  {}", c.name, c.base_median,
+					 c.current_median, c.ratio, c.ci.low, c.ci.high, c.p_value, bench_stats::to_string(c.verdict));
+		slower += c.verdict == bench_stats::Verdict::slower ? 1 : 0;
+	}
+	std::println("{} regression(s) beyond {}%", slower, options.threshold * 100);
+	return slower == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+std::vector<Benchmark> all_benchmarks() {
+	std::vector<Benchmark> benchmarks;
+	benchmarks.push_back(button_benchmark<ButtonWithConcept<MockedDigitalInput>>("button_concept_read"));
+	benchmarks.push_back(button_benchmark<ButtonWithSfinae<MockedDigitalInput>>("button_sfinae_read"));
+	std::ranges::move(kernel_benchmarks(), std::back_inserter(benchmarks));
+	std::ranges::move(user_benchmarks(), std::back_inserter(benchmarks));
+	return benchmarks;
+}
+
+int main(int argc, char **argv) {
+	StartupProfile startup; // first, so --startup sees everything before main as loader / static init
+
+	std::string out_path, label, filter, config_path;
+	std::vector<std::string> compare_paths;
+	std::vector<std::size_t> farm_devices, thread_counts;
+	std::vector<std::size_t> element_counts;
+	bool farm = false, memory = false, startup_mode = false, scale = false;
+	PollPath farm_path = PollPath::batched;
+	BenchOptions options;
+	bench_stats::CompareOptions compare_options;
+	try {
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view arg = argv[i];
+			auto next = [&]() -> std::string {
+				if (i + 1 >= argc) {
+					throw std::invalid_argument(std::string(arg) + " needs a value");
+				}
+				return argv[++i];
+			};
+			if (arg == "--out") {
+				out_path = next();
+			}
+			else if (arg == "--label") {
+				label = next();
+			}
+			else if (arg == "--filter") {
+				filter = next();
+			}
+			else if (arg == "--samples") {
+				options.samples = std::stoul(next());
+			}
+			else if (arg == "--min-time-ms") {
+				options.min_sample_time = std::chrono::milliseconds(std::stol(next()));
+			}
+			else if (arg == "--compare") {
+				compare_paths = { next(), next() };
+			}
+			else if (arg == "--threshold") {
+				compare_options.threshold = std::stod(next());
+			}
+			else if (arg == "--alpha") {
+				compare_options.alpha = std::stod(next());
+			}
+			else if (arg == "--farm") {
+				farm = true;
+			}
+			else if (arg == "--devices") {
+				farm_devices = parse_list(next());
+			}
+			else if (arg == "--threads") {
+				thread_counts = parse_list(next());
+			}
+			else if (arg == "--button") {
+				farm_path = PollPath::button;
+			}
+			else if (arg == "--memory") {
+				memory = true;
+			}
+			else if (arg == "--elements") {
+				element_counts = parse_list(next());
+			}
+			else if (arg == "--scale") {
+				scale = true;
+			}
+			else if (arg == "--startup") {
+				startup_mode = true;
+			}
+			else if (arg == "--config") {
+				config_path = next();
+			}
+			else if (arg == "--list") {
+				for (const auto &b : all_benchmarks()) {
+					std::println("{}", b.name);
+				}
+				return EXIT_SUCCESS;
+			}
+			else {
+				throw std::invalid_argument("unknown argument " + std::string(arg));
+			}
+		}
+
+		if (!compare_paths.empty()) {
+			return compare_files(compare_paths[0], compare_paths[1], compare_options);
+		}
+		if (farm) {
+			return farm_sweep(farm_devices, thread_counts, farm_path);
+		}
+		if (memory) {
+			return memory_report(element_counts);
+		}
+		if (startup_mode) {
+			return startup_report(startup, config_path, out_path);
+		}
+
+		BenchRun run{ BenchEnvironment::capture(label), {} };
+		std::println("{} | {} cores | {} | {}", run.environment.cpu, run.environment.cores, run.environment.compiler,
+					 run.environment.build);
+		if (scale) {
+			scale_report(element_counts, thread_counts, filter, options, run);
+		}
+		else {
+			for (const auto &b : all_benchmarks()) {
+				if (!filter.empty() && b.name.find(filter) == std::string::npos) {
+					continue;
+				}
+				run.results.push_back(measure(b.name, b.run, options));
+				const auto &r = run.results.back();
+				std::println("{:<32} {:>12.1f} ns/op  (median of {} x {} iterations)", r.name,
+							 bench_stats::median(r.ns_per_op), r.ns_per_op.size(), r.iterations);
+			}
+		}
+		if (!out_path.empty()) {
+			save_bench_run(out_path, run);
+		}
+		return EXIT_SUCCESS;
+	}
+	catch (const std::exception &e) {
+		std::println(stderr, "{}", e.what());
+		return 2;
+	}
+}
@@ -0,0 +1,471 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+//================================
+// 			BENCH HARNESS
+//================================
+// A benchmark is a callable taking an iteration count and doing the measured operation that many times. The
+// harness grows the count until one sample takes at least `min_sample_time`, then records `samples` timings of
+// that many iterations as ns per operation. Setup belongs outside the callable (capture prepared data).
+
+// Keeps a computed value alive so the optimizer cannot drop the work that produced it.
+template<typename T>
+inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void *sink;
+	sink = &value;
+#endif
+}
+
+template<typename F>
+concept BenchmarkConcept = std::invocable<F &, std::size_t>;
+
+struct BenchOptions {
+	std::size_t samples = 20;
+	std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds(10);
+};
+
+struct BenchResult {
+	std::string name;
+	std::size_t iterations{}; // per sample
+	std::vector<double> ns_per_op;
+};
+
+template<BenchmarkConcept F>
+BenchResult measure(std::string name, F &&fn, BenchOptions options = {}) {
+	using clock = std::chrono::steady_clock;
+	auto time = [&](std::size_t iterations) {
+		const auto start = clock::now();
+		fn(iterations);
+		return clock::now() - start;
+	};
+
+	std::size_t iterations = 1;
+	for (auto t = time(iterations); t < options.min_sample_time; t = time(iterations)) {
+		// aim a little past the target so calibration converges in a few steps
+		const double scale = t.count() <= 0 ? 10.0 : 1.2 * static_cast<double>(options.min_sample_time.count()) /
+														 static_cast<double>(t.count());
+		iterations = std::max(iterations + 1, static_cast<std::size_t>(static_cast<double>(iterations) *
+																		std::min(scale, 10.0)));
+	}
+
+	BenchResult result{ std::move(name), iterations, {} };
+	result.ns_per_op.reserve(options.samples);
+	for (std::size_t s = 0; s < options.samples; ++s) {
+		const std::chrono::duration<double, std::nano> t = time(iterations);
+		result.ns_per_op.push_back(t.count() / static_cast<double>(iterations));
+	}
+	return result;
+}
+
+//================================
+// 			BENCH ENVIRONMENT
+//================================
+// Where a run came from; two runs are only comparable when these mostly agree.
+struct BenchEnvironment {
+	std::string label; // free form, typically a commit id
+	std::string timestamp;
+	std::string host;
+	std::string cpu;
+	unsigned cores{};
+	std::string compiler;
+	std::string build; // "release"/"debug" plus notable target flags
+
+	static BenchEnvironment capture(std::string label = {}) {
+		BenchEnvironment env;
+		env.label = std::move(label);
+
+		const std::time_t now = std::time(nullptr);
+		char stamp[32]{};
+		std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+		env.timestamp = stamp;
+
+#if defined(__unix__) || defined(__APPLE__)
+		char host[256]{};
+		if (::gethostname(host, sizeof(host) - 1) == 0) {
+			env.host = host;
+		}
+#endif
+		std::ifstream cpuinfo("/proc/cpuinfo");
+		for (std::string line; std::getline(cpuinfo, line);) {
+			if (line.starts_with("model name")) {
+				env.cpu = line.substr(line.find(':') + 2);
+				break;
+			}
+		}
+		env.cores = std::thread::hardware_concurrency();
+
+#if defined(__clang__)
+		env.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+		env.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+		env.compiler = "msvc " + std::to_string(_MSC_FULL_VER);
+#endif
+
+#if defined(NDEBUG)
+		env.build = "release";
+#else
+		env.build = "debug";
+#endif
+#if defined(__AVX2__)
+		env.build += " avx2";
+#endif
+#if defined(__BMI2__)
+		env.build += " bmi2";
+#endif
+		return env;
+	}
+};
+
+struct BenchRun {
+	BenchEnvironment environment;
+	std::vector<BenchResult> results;
+
+	const BenchResult *find(std::string_view name) const {
+		auto it = std::ranges::find(results, name, &BenchResult::name);
+		return it == results.end() ? nullptr : &*it;
+	}
+};
+
+//================================
+// 			BENCH JSON
+//================================
+// Just enough JSON for the result files: writer for BenchRun, and a small DOM parser to read them back.
+namespace bench_json {
+
+struct Value;
+using Object = std::map<std::string, Value, std::less<>>;
+using Array = std::vector<Value>;
+
+struct Value {
+	std::variant<std::nullptr_t, bool, double, std::string, Array, Object> v;
+
+	const Value &operator[](std::string_view key) const {
+		const auto &object = std::get<Object>(v);
+		auto it = object.find(key);
+		if (it == object.end()) {
+			throw std::runtime_error("benchmark JSON: missing key '" + std::string(key) + "'");
+		}
+		return it->second;
+	}
+
+	const std::string &str() const {
+		return std::get<std::string>(v);
+	}
+
+	// null reads as NaN: number() writes non-finite values as null.
+	double num() const {
+		if (std::holds_alternative<std::nullptr_t>(v)) {
+			return std::numeric_limits<double>::quiet_NaN();
+		}
+		return std::get<double>(v);
+	}
+
+	const Array &arr() const {
+		return std::get<Array>(v);
+	}
+};
+
+inline std::string quote(std::string_view s) {
+	std::string out = "\"";
+	for (char c : s) {
+		switch (c) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char esc[8];
+				std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+				out += esc;
+			}
+			else {
+				out += c;
+			}
+		}
+	}
+	return out + '"';
+}
+
+// JSON has no NaN or infinity, so those are written as null.
+inline std::string number(double d) {
+	if (!std::isfinite(d)) {
+		return "null";
+	}
+	char buf[32];
+	auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), d); // shortest round-trip form
+	return std::string(buf, end);
+}
+
+class Parser {
+public:
+	explicit Parser(std::string_view text) : s_(text) {}
+
+	Value parse() {
+		Value v = value();
+		skip_ws();
+		if (i_ != s_.size()) {
+			fail("trailing characters");
+		}
+		return v;
+	}
+
+private:
+	[[noreturn]] void fail(const char *what) const {
+		throw std::runtime_error("benchmark JSON: " + std::string(what) + " at offset " + std::to_string(i_));
+	}
+
+	void skip_ws() {
+		while (i_ < s_.size() && (s_[i_] == ' ' || s_[i_] == '\n' || s_[i_] == '\r' || s_[i_] == '\t')) {
+			++i_;
+		}
+	}
+
+	bool consume(char c) {
+		skip_ws();
+		if (i_ < s_.size() && s_[i_] == c) {
+			++i_;
+			return true;
+		}
+		return false;
+	}
+
+	void expect_char(char c) {
+		if (!consume(c)) {
+			fail("unexpected character");
+		}
+	}
+
+	Value value() {
+		skip_ws();
+		if (i_ >= s_.size()) {
+			fail("unexpected end");
+		}
+		const char c = s_[i_];
+		if (c == '{') {
+			++i_;
+			Object object;
+			if (!consume('}')) {
+				do {
+					skip_ws();
+					std::string key = string();
+					expect_char(':');
+					object.emplace(std::move(key), value());
+				} while (consume(','));
+				expect_char('}');
+			}
+			return { std::move(object) };
+		}
+		if (c == '[') {
+			++i_;
+			Array array;
+			if (!consume(']')) {
+				do {
+					array.push_back(value());
+				} while (consume(','));
+				expect_char(']');
+			}
+			return { std::move(array) };
+		}
+		if (c == '"') {
+			return { string() };
+		}
+		for (auto [word, v] : { std::pair<std::string_view, Value>{ "true", { true } }, { "false", { false } },
+								 { "null", { nullptr } } }) {
+			if (s_.substr(i_).starts_with(word)) {
+				i_ += word.size();
+				return v;
+			}
+		}
+		double d{};
+		auto [end, ec] = std::from_chars(s_.data() + i_, s_.data() + s_.size(), d);
+		if (ec != std::errc{} || !std::isfinite(d)) {
+			fail("bad value"); // from_chars also takes "nan" and "inf"
+		}
+		i_ = static_cast<std::size_t>(end - s_.data());
+		return { d };
+	}
+
+	std::string string() {
+		if (i_ >= s_.size() || s_[i_] != '"') {
+			fail("expected string");
+		}
+		++i_;
+		std::string out;
+		while (i_ < s_.size() && s_[i_] != '"') {
+			char c = s_[i_++];
+			if (c == '\\' && i_ < s_.size()) {
+				c = s_[i_++];
+				switch (c) {
+				case 'n': out += '\n'; break;
+				case 't': out += '\t'; break;
+				case 'r': out += '\r'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'u': {
+					char32_t code = hex4();
+					if (code >= 0xdc00 && code < 0xe000) {
+						fail("unpaired surrogate");
+					}
+					if (code >= 0xd800 && code < 0xdc00) {
+						if (!s_.substr(i_).starts_with("\\u")) {
+							fail("unpaired surrogate");
+						}
+						i_ += 2;
+						const char32_t low = hex4();
+						if (low < 0xdc00 || low >= 0xe000) {
+							fail("unpaired surrogate");
+						}
+						code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+					}
+					append_utf8(out, code);
+					break;
+				}
+				default: out += c;
+				}
+			}
+			else {
+				out += c;
+			}
+		}
+		if (i_ >= s_.size()) {
+			fail("unterminated string");
+		}
+		++i_;
+		return out;
+	}
+
+	// The four hex digits of a \u escape.
+	char32_t hex4() {
+		unsigned code{};
+		const char *first = s_.data() + i_, *last = first + std::min<std::size_t>(4, s_.size() - i_);
+		auto [end, ec] = std::from_chars(first, last, code, 16);
+		if (ec != std::errc{} || end != first + 4) {
+			fail("bad escape");
+		}
+		i_ += 4;
+		return code;
+	}
+
+	static void append_utf8(std::string &out, char32_t code) {
+		if (code < 0x80) {
+			out += static_cast<char>(code);
+		}
+		else if (code < 0x800) {
+			out += static_cast<char>(0xc0 | code >> 6);
+			out += static_cast<char>(0x80 | (code & 0x3f));
+		}
+		else if (code < 0x10000) {
+			out += static_cast<char>(0xe0 | code >> 12);
+			out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+			out += static_cast<char>(0x80 | (code & 0x3f));
+		}
+		else {
+			out += static_cast<char>(0xf0 | code >> 18);
+			out += static_cast<char>(0x80 | (code >> 12 & 0x3f));
+			out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+			out += static_cast<char>(0x80 | (code & 0x3f));
+		}
+	}
+
+	std::string_view s_;
+	std::size_t i_{};
+};
+
+} // namespace bench_json
+
+inline std::string to_json(const BenchRun &run) {
+	using bench_json::number;
+	using bench_json::quote;
+	const auto &env = run.environment;
+	std::string out = "{\n  \"environment\": {";
+	out += "\n    \"label\": " + quote(env.label) + ",";
+	out += "\n    \"timestamp\": " + quote(env.timestamp) + ",";
+	out += "\n    \"host\": " + quote(env.host) + ",";
+	out += "\n    \"cpu\": " + quote(env.cpu) + ",";
+	out += "\n    \"cores\": " + std::to_string(env.cores) + ",";
+	out += "\n    \"compiler\": " + quote(env.compiler) + ",";
+	out += "\n    \"build\": " + quote(env.build);
+	out += "\n  },\n  \"results\": [";
+	for (std::size_t r = 0; r < run.results.size(); ++r) {
+		const auto &result = run.results[r];
+		out += r == 0 ? "\n" : ",\n";
+		out += "    { \"name\": " + quote(result.name) + ", \"iterations\": " + std::to_string(result.iterations) +
+			   ", \"ns_per_op\": [";
+		for (std::size_t s = 0; s < result.ns_per_op.size(); ++s) {
+			out += (s == 0 ? "" : ", ") + number(result.ns_per_op[s]);
+		}
+		out += "] }";
+	}
+	out += "\n  ]\n}\n";
+	return out;
+}
+
+inline BenchRun bench_run_from_json(std::string_view text) {
+	const bench_json::Value root = bench_json::Parser(text).parse();
+	BenchRun run;
+	const auto &env = root["environment"];
+	run.environment = { .label = env["label"].str(),
+						.timestamp = env["timestamp"].str(),
+						.host = env["host"].str(),
+						.cpu = env["cpu"].str(),
+						.cores = static_cast<unsigned>(env["cores"].num()),
+						.compiler = env["compiler"].str(),
+						.build = env["build"].str() };
+	for (const auto &r : root["results"].arr()) {
+		BenchResult result{ r["name"].str(), static_cast<std::size_t>(r["iterations"].num()), {} };
+		for (const auto &s : r["ns_per_op"].arr()) {
+			result.ns_per_op.push_back(s.num());
+		}
+		run.results.push_back(std::move(result));
+	}
+	return run;
+}
+
+inline void save_bench_run(const std::string &path, const BenchRun &run) {
+	std::ofstream out(path);
+	out << to_json(run);
+	if (!out) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+inline BenchRun load_bench_run(const std::string &path) {
+	std::ifstream in(path);
+	if (!in) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	std::stringstream text;
+	text << in.rdbuf();
+	return bench_run_from_json(text.str());
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+
+//================================
+// 			BENCH STATS
+//================================
+// Deciding whether two sets of timings differ. Benchmark samples are skewed and sometimes bimodal, so nothing here
+// assumes normality: Mann-Whitney U tests whether one run tends to be slower than the other, and a bootstrap
+// gives a confidence interval for the ratio of medians (new / base), which is what a threshold is checked against.
+namespace bench_stats {
+
+inline double median(std::vector<double> v) {
+	if (v.empty()) {
+		return 0;
+	}
+	const std::size_t mid = v.size() / 2;
+	std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(mid), v.end());
+	if (v.size() % 2 != 0) {
+		return v[mid];
+	}
+	const double upper = v[mid];
+	return (*std::max_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(mid)) + upper) / 2;
+}
+
+// Two-sided p-value of the Mann-Whitney U test, normal approximation with tie and continuity correction
+// (good from about 8 samples per side).
+inline double mann_whitney_p(std::span<const double> a, std::span<const double> b) {
+	const std::size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+	if (n1 == 0 || n2 == 0) {
+		return 1;
+	}
+	struct Tagged {
+		double value;
+		bool from_a;
+	};
+	std::vector<Tagged> all;
+	all.reserve(n);
+	for (double x : a) {
+		all.push_back({ x, true });
+	}
+	for (double x : b) {
+		all.push_back({ x, false });
+	}
+	std::ranges::sort(all, {}, &Tagged::value);
+
+	double rank_sum_a = 0, tie_term = 0;
+	for (std::size_t i = 0; i < n;) {
+		std::size_t j = i + 1;
+		while (j < n && all[j].value == all[i].value) {
+			++j;
+		}
+		const double rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2; // average of ranks i+1 .. j
+		for (std::size_t k = i; k < j; ++k) {
+			rank_sum_a += all[k].from_a ? rank : 0;
+		}
+		const double t = static_cast<double>(j - i);
+		tie_term += t * t * t - t;
+		i = j;
+	}
+
+	const double dn1 = static_cast<double>(n1), dn2 = static_cast<double>(n2), dn = static_cast<double>(n);
+	const double u = rank_sum_a - dn1 * (dn1 + 1) / 2;
+	const double mean = dn1 * dn2 / 2;
+	const double variance = dn1 * dn2 / 12 * ((dn + 1) - tie_term / (dn * (dn - 1)));
+	if (variance <= 0) {
+		return 1; // every sample equal
+	}
+	const double z = std::max(std::abs(u - mean) - 0.5, 0.0) / std::sqrt(variance);
+	return std::erfc(z / std::sqrt(2.0));
+}
+
+struct Interval {
+	double low;
+	double high;
+};
+
+// Percentile bootstrap interval for median(current) / median(base). Seeded, so reruns give the same interval.
+inline Interval bootstrap_ratio_ci(std::span<const double> base, std::span<const double> current,
+								   double confidence = 0.95, std::size_t resamples = 2000) {
+	if (base.empty() || current.empty()) {
+		return { 0, 0 };
+	}
+	std::mt19937_64 rng(0x5eed);
+	auto resample_median = [&](std::span<const double> s, std::vector<double> &scratch) {
+		std::uniform_int_distribution<std::size_t> pick(0, s.size() - 1);
+		scratch.resize(s.size());
+		for (auto &x : scratch) {
+			x = s[pick(rng)];
+		}
+		return median(scratch);
+	};
+	std::vector<double> ratios, scratch;
+	ratios.reserve(resamples);
+	for (std::size_t r = 0; r < resamples; ++r) {
+		const double b = resample_median(base, scratch);
+		const double c = resample_median(current, scratch);
+		ratios.push_back(b > 0 ? c / b : 1);
+	}
+	std::ranges::sort(ratios);
+	const double tail = (1 - confidence) / 2;
+	auto at = [&](double q) {
+		return ratios[std::min(ratios.size() - 1, static_cast<std::size_t>(q * static_cast<double>(ratios.size())))];
+	};
+	return { at(tail), at(1 - tail) };
+}
+
+enum class Verdict { same, faster, slower, added, missing };
+
+struct CompareOptions {
+	double threshold = 0.05; // relative change below this is never flagged
+	double alpha = 0.01;	 // significance level for the U test
+	double confidence = 0.95;
+};
+
+struct Comparison {
+	std::string name;
+	double base_median{};
+	double current_median{};
+	double ratio{}; // current / base; > 1 means slower
+	Interval ci{};
+	double p_value{ 1 };
+	Verdict verdict{ Verdict::same };
+};
+
+// A benchmark is flagged only when all three agree: the U test rejects "same distribution", the median ratio is
+// beyond the threshold, and the bootstrap interval excludes 1.
+inline Comparison compare(const BenchResult &base, const BenchResult &current, CompareOptions options = {}) {
+	Comparison c;
+	c.name = current.name;
+	c.base_median = median(base.ns_per_op);
+	c.current_median = median(current.ns_per_op);
+	c.ratio = c.base_median > 0 ? c.current_median / c.base_median : 1;
+	c.ci = bootstrap_ratio_ci(base.ns_per_op, current.ns_per_op, options.confidence);
+	c.p_value = mann_whitney_p(base.ns_per_op, current.ns_per_op);
+	if (c.p_value < options.alpha) {
+		if (c.ratio > 1 + options.threshold && c.ci.low > 1) {
+			c.verdict = Verdict::slower;
+		}
+		else if (c.ratio < 1 - options.threshold && c.ci.high < 1) {
+			c.verdict = Verdict::faster;
+		}
+	}
+	return c;
+}
+
+// Every benchmark of `current` (those not in `base` as added), plus those only in `base` (as missing).
+inline std::vector<Comparison> compare(const BenchRun &base, const BenchRun &current, CompareOptions options = {}) {
+	std::vector<Comparison> out;
+	for (const auto &result : current.results) {
+		if (const BenchResult *old = base.find(result.name)) {
+			out.push_back(compare(*old, result, options));
+		}
+		else {
+			out.push_back(
+				{ .name = result.name, .current_median = median(result.ns_per_op), .verdict = Verdict::added });
+		}
+	}
+	for (const auto &result : base.results) {
+		if (current.find(result.name) == nullptr) {
+			out.push_back(
+				{ .name = result.name, .base_median = median(result.ns_per_op), .verdict = Verdict::missing });
+		}
+	}
+	return out;
+}
+
+inline const char *to_string(Verdict v) {
+	switch (v) {
+	case Verdict::faster: return "faster";
+	case Verdict::slower: return "SLOWER";
+	case Verdict::added: return "added";
+	case Verdict::missing: return "missing";
+	default: return "same";
+	}
+}
+
+} // namespace bench_stats
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "digital_input.hpp"
+
+// Pointer-based core in C++17, so the firmware build (fast_paths_sfinae.hpp) runs the same loops; the span and
+// concept overloads are C++20 conveniences on top.
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
+//================================
+// 			BATCHED POLLING
+//================================
+// One read() per device into a byte per device (0 / 1), the input format of the debouncer below.
+template<typename DIn, typename = std::enable_if_t<is_digital_input_new_sfinae_type_trait_v<DIn>>>
+void poll_inputs(DIn *inputs, std::size_t n, std::uint8_t *levels) {
+	for (std::size_t i = 0; i < n; ++i) {
+		levels[i] = inputs[i].read() != 0 ? 1 : 0;
+	}
+}
+
+#if defined(__cpp_concepts) && defined(__cpp_lib_span)
+template<DigitalInputConcept DIn>
+void poll_inputs(std::span<DIn> inputs, std::span<std::uint8_t> levels) {
+	assert(levels.size() >= inputs.size());
+	poll_inputs(inputs.data(), inputs.size(), levels.data());
+}
+#endif
+
+//================================
+// 			DEBOUNCE
+//================================
+// Counter debounce for many inputs at once: a device's stable level changes after `threshold` consecutive polls
+// disagree with it, and a single agreeing poll resets the count. State is two bytes per device in separate
+// arrays, and the update is branch-free byte arithmetic, so compilers vectorize it (16/32 devices per
+// instruction with SSE2/AVX2).
+namespace debounce_detail {
+
+// For i < n: updates stable[i] / count[i] with raw[i] and sets changed[i] to 1 where stable[i] flipped.
+inline void step(std::uint8_t *stable, std::uint8_t *count, const std::uint8_t *raw, std::uint8_t *changed,
+				 std::size_t n, std::uint8_t threshold) {
+	for (std::size_t i = 0; i < n; ++i) {
+		const std::uint8_t differs = static_cast<std::uint8_t>(raw[i] ^ stable[i]);			  // 0 / 1
+		const std::uint8_t next = static_cast<std::uint8_t>((count[i] + 1) & -differs);		  // 0 when agreeing
+		const std::uint8_t flip = static_cast<std::uint8_t>(next >= threshold);				  // 0 / 1
+		stable[i] = static_cast<std::uint8_t>(stable[i] ^ flip);
+		count[i] = static_cast<std::uint8_t>(next & (flip - 1));								  // 0 after a flip
+		changed[i] = flip;
+	}
+}
+
+} // namespace debounce_detail
+
+class Debouncer {
+public:
+	explicit Debouncer(std::size_t devices, std::uint8_t threshold = 3, std::uint8_t initial_level = 0)
+		: stable_(devices, initial_level), count_(devices, 0), threshold_(threshold < 1 ? 1 : threshold) {}
+
+	std::size_t size() const {
+		return stable_.size();
+	}
+
+	std::uint8_t threshold() const {
+		return threshold_;
+	}
+
+	std::uint8_t level(std::size_t device) const {
+		return stable_[device];
+	}
+
+	// Feeds one poll of devices first .. first + n. changed[k] becomes 1 where device first + k switched.
+	// Disjoint ranges may be updated from different threads.
+	void update(std::size_t first, const std::uint8_t *raw, std::size_t n, std::uint8_t *changed) {
+		assert(first + n <= size());
+		debounce_detail::step(stable_.data() + first, count_.data() + first, raw, changed, n, threshold_);
+	}
+
+#if defined(__cpp_lib_span)
+	void update(std::size_t first, std::span<const std::uint8_t> raw, std::span<std::uint8_t> changed) {
+		assert(changed.size() >= raw.size());
+		update(first, raw.data(), raw.size(), changed.data());
+	}
+#endif
+
+private:
+	std::vector<std::uint8_t> stable_;
+	std::vector<std::uint8_t> count_;
+	std::uint8_t threshold_;
+};
@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "debounce.hpp"
+#include "digital_input.hpp"
+#include "parallel.hpp"
+
+//================================
+// 			DEVICE FARM
+//================================
+// Synthetic population of digital inputs for load testing, from one to tens of millions. Each device has a true
+// level that toggles as a Poisson process; reads see contact bounce for a while after every toggle plus
+// background noise, and every read takes a sampled latency. Time is simulated (microseconds) so ten million
+// devices can be polled without sleeping, while the polling, debouncing and event code runs for real.
+// State is SoA, about 20 bytes per device, and every device draws from its own RNG stream, so results don't
+// depend on the thread count.
+enum class LatencyModel { fixed, exponential, lognormal };
+
+struct DeviceFarmConfig {
+	std::size_t devices = 100'000;
+	double toggle_rate_hz = 2.0;	   // mean true toggles per device per second
+	double bounce_us = 2'000;		   // after a toggle, reads are random for this long...
+	double bounce_probability = 0.5;   // ...each one wrong with this probability
+	double noise_probability = 1e-4;   // any other read is wrong with this probability
+	LatencyModel latency = LatencyModel::lognormal;
+	double latency_mean_us = 50;
+	double latency_sigma = 0.5;		   // lognormal shape
+	std::uint64_t seed = 1;
+};
+
+// Reads a config from "key = value" lines (keys as in DeviceFarmConfig, latency = fixed | exponential |
+// lognormal); '#' starts a comment and missing keys keep their defaults.
+inline DeviceFarmConfig parse_device_farm_config(std::string_view text) {
+	DeviceFarmConfig config;
+	auto trim = [](std::string_view s) {
+		const std::size_t first = s.find_first_not_of(" \t\r");
+		if (first == std::string_view::npos) {
+			return std::string_view{};
+		}
+		return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+	};
+	for (std::size_t line_no = 1; !text.empty(); ++line_no) {
+		const std::size_t eol = std::min(text.find('\n'), text.size());
+		std::string_view line = text.substr(0, eol);
+		text.remove_prefix(std::min(eol + 1, text.size()));
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty()) {
+			continue;
+		}
+		const std::size_t eq = line.find('=');
+		auto fail = [&](const std::string &what) {
+			throw std::invalid_argument("device farm config line " + std::to_string(line_no) + ": " + what);
+		};
+		if (eq == std::string_view::npos) {
+			fail("expected key = value");
+		}
+		const std::string_view key = trim(line.substr(0, eq)), value = trim(line.substr(eq + 1));
+		auto number = [&]<typename T>(T &out) {
+			const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), out);
+			if (ec != std::errc{} || end != value.data() + value.size()) {
+				fail("bad value for " + std::string(key));
+			}
+		};
+		if (key == "latency") {
+			if (value == "fixed") {
+				config.latency = LatencyModel::fixed;
+			}
+			else if (value == "exponential") {
+				config.latency = LatencyModel::exponential;
+			}
+			else if (value == "lognormal") {
+				config.latency = LatencyModel::lognormal;
+			}
+			else {
+				fail("unknown latency model " + std::string(value));
+			}
+		}
+		else if (key == "devices") {
+			number(config.devices);
+		}
+		else if (key == "toggle_rate_hz") {
+			number(config.toggle_rate_hz);
+		}
+		else if (key == "bounce_us") {
+			number(config.bounce_us);
+		}
+		else if (key == "bounce_probability") {
+			number(config.bounce_probability);
+		}
+		else if (key == "noise_probability") {
+			number(config.noise_probability);
+		}
+		else if (key == "latency_mean_us") {
+			number(config.latency_mean_us);
+		}
+		else if (key == "latency_sigma") {
+			number(config.latency_sigma);
+		}
+		else if (key == "seed") {
+			number(config.seed);
+		}
+		else {
+			fail("unknown key " + std::string(key));
+		}
+	}
+	if (config.devices == 0 || config.toggle_rate_hz <= 0) {
+		throw std::invalid_argument("device farm config: devices and toggle_rate_hz must be positive");
+	}
+	return config;
+}
+
+inline DeviceFarmConfig load_device_farm_config(const std::string &path) {
+	std::ifstream in(path);
+	if (!in) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return parse_device_farm_config(text);
+}
+
+class DeviceFarm {
+public:
+	explicit DeviceFarm(const DeviceFarmConfig &config)
+		: config_(config), rng_(config.devices), level_(config.devices), last_toggle_(config.devices),
+		  next_toggle_(config.devices) {
+		parallel_for(config.devices, 64 * 1024, [&](std::size_t b, std::size_t e) {
+			for (std::size_t i = b; i < e; ++i) {
+				rng_[i] = config_.seed * 0x9e3779b97f4a7c15ull + i;
+				level_[i] = 0;
+				last_toggle_[i] = 0;
+				next_toggle_[i] = clamp_time(exponential_us(rng_[i], 1e6 / config_.toggle_rate_hz));
+			}
+		});
+	}
+
+	std::size_t size() const {
+		return level_.size();
+	}
+
+	const DeviceFarmConfig &config() const {
+		return config_;
+	}
+
+	// Simulated time of the reads that follow.
+	void set_time(std::uint32_t now_us) {
+		now_us_ = now_us;
+	}
+
+	// One read of `device` at the current time: the level it reports, and the read's latency.
+	struct Sample {
+		std::uint8_t level;
+		std::uint32_t latency_us;
+	};
+
+	Sample sample(std::size_t device) {
+		std::uint64_t &rng = rng_[device];
+		const double period_us = 1e6 / config_.toggle_rate_hz;
+		while (next_toggle_[device] <= now_us_) {
+			level_[device] ^= 1;
+			last_toggle_[device] = next_toggle_[device];
+			next_toggle_[device] = clamp_time(next_toggle_[device] + exponential_us(rng, period_us));
+		}
+		const bool bouncing = now_us_ - last_toggle_[device] < config_.bounce_us && last_toggle_[device] != 0;
+		const double p_wrong = bouncing ? config_.bounce_probability : config_.noise_probability;
+		const std::uint8_t wrong = uniform(rng) < p_wrong ? 1 : 0;
+		return { static_cast<std::uint8_t>(level_[device] ^ wrong), latency_us(rng) };
+	}
+
+	// Time of the last true toggle of `device` (0 if none yet).
+	std::uint32_t last_toggle_us(std::size_t device) const {
+		return last_toggle_[device];
+	}
+
+	std::uint8_t true_level(std::size_t device) const {
+		return level_[device];
+	}
+
+	// Per-device handle that satisfies DigitalInputConcept, so ButtonWithConcept / ButtonWithSfinae can poll it.
+	class Input {
+	public:
+		Input(DeviceFarm *farm, std::size_t device) : farm_(farm), device_(device) {}
+
+		void init() {}
+
+		int read() {
+			const Sample s = farm_->sample(device_);
+			last_latency_us_ = s.latency_us;
+			return s.level;
+		}
+
+		std::uint32_t last_latency_us() const {
+			return last_latency_us_;
+		}
+
+	private:
+		DeviceFarm *farm_;
+		std::size_t device_;
+		std::uint32_t last_latency_us_{};
+	};
+
+	Input input(std::size_t device) {
+		return { this, device };
+	}
+
+private:
+	static std::uint64_t next(std::uint64_t &state) {
+		// splitmix64
+		std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	static double uniform(std::uint64_t &state) {
+		return static_cast<double>(next(state) >> 11) * 0x1.0p-53;
+	}
+
+	static double exponential_us(std::uint64_t &state, double mean) {
+		return -mean * std::log1p(-uniform(state));
+	}
+
+	static std::uint32_t clamp_time(double us) {
+		return static_cast<std::uint32_t>(std::min(us, 4.0e9));
+	}
+
+	std::uint32_t latency_us(std::uint64_t &rng) const {
+		switch (config_.latency) {
+		case LatencyModel::fixed:
+			return static_cast<std::uint32_t>(config_.latency_mean_us);
+		case LatencyModel::exponential:
+			return clamp_time(exponential_us(rng, config_.latency_mean_us));
+		default: {
+			// lognormal with the configured mean: mu = ln(mean) - sigma^2 / 2; Box-Muller for the normal draw
+			const double s = config_.latency_sigma;
+			const double radius = std::sqrt(-2 * std::log1p(-uniform(rng)));
+			const double normal = radius * std::cos(6.283185307179586 * uniform(rng));
+			return clamp_time(std::exp(std::log(config_.latency_mean_us) - s * s / 2 + s * normal));
+		}
+		}
+	}
+
+	DeviceFarmConfig config_;
+	std::vector<std::uint64_t> rng_;
+	std::vector<std::uint8_t> level_;
+	std::vector<std::uint32_t> last_toggle_;
+	std::vector<std::uint32_t> next_toggle_;
+	std::uint32_t now_us_{};
+};
+
+static_assert(DigitalInputConcept<DeviceFarm::Input>);
+
+//================================
+// 			FARM LOAD RUN
+//================================
+// Polls every device each round (through ButtonWithConcept, or straight from the farm in batches), debounces
+// the readings and turns flips into events. Event latency is simulated time from the true toggle to the poll
+// that emitted the event, plus that read's latency.
+enum class PollPath { button, batched };
+
+struct FarmLoadOptions {
+	std::size_t threads = 1; // 0: ThreadPool::current()
+	std::size_t rounds = 100;
+	std::uint32_t poll_interval_us = 1'000;
+	std::uint8_t debounce_polls = 3;
+	PollPath path = PollPath::batched;
+};
+
+// Log-linear latency histogram: 8 sub-buckets per power of two, so quantiles are within ~10%.
+class LatencyHistogram {
+public:
+	static constexpr std::size_t sub_bits = 3;
+	static constexpr std::size_t buckets = (32 - sub_bits + 1) << sub_bits;
+
+	void add(std::uint32_t us) {
+		++counts_[bucket(us)];
+		++total_;
+		max_ = std::max(max_, us);
+	}
+
+	void merge(const LatencyHistogram &other) {
+		for (std::size_t b = 0; b < buckets; ++b) {
+			counts_[b] += other.counts_[b];
+		}
+		total_ += other.total_;
+		max_ = std::max(max_, other.max_);
+	}
+
+	std::uint64_t count() const {
+		return total_;
+	}
+
+	std::uint32_t max() const {
+		return max_;
+	}
+
+	// Upper edge of the bucket holding quantile q.
+	std::uint32_t quantile(double q) const {
+		const auto target = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total_)));
+		std::uint64_t seen = 0;
+		for (std::size_t b = 0; b < buckets; ++b) {
+			seen += counts_[b];
+			if (seen >= target && seen != 0) {
+				return std::min(upper(b), max_);
+			}
+		}
+		return max_;
+	}
+
+private:
+	static std::size_t bucket(std::uint32_t v) {
+		if (v < (1u << sub_bits)) {
+			return v;
+		}
+		const unsigned exp = static_cast<unsigned>(std::bit_width(v)) - 1; // >= sub_bits
+		const unsigned sub = (v >> (exp - sub_bits)) & ((1u << sub_bits) - 1);
+		return ((exp - sub_bits + 1) << sub_bits) + sub;
+	}
+
+	static std::uint32_t upper(std::size_t b) {
+		if (b < (1u << sub_bits)) {
+			return static_cast<std::uint32_t>(b);
+		}
+		const std::size_t exp = (b >> sub_bits) + sub_bits - 1;
+		const std::size_t sub = b & ((1u << sub_bits) - 1);
+		const std::uint64_t edge = ((std::uint64_t{ 1 } << sub_bits) + sub + 1) << (exp - sub_bits);
+		return static_cast<std::uint32_t>(std::min<std::uint64_t>(edge - 1, 0xffffffffu));
+	}
+
+	std::array<std::uint64_t, buckets> counts_{};
+	std::uint64_t total_{};
+	std::uint32_t max_{};
+};
+
+struct FarmLoadReport {
+	std::size_t devices{};
+	std::size_t threads{};
+	std::uint64_t reads{};
+	std::uint64_t events{};
+	std::uint64_t spurious_events{}; // debounced level disagrees with the true level (noise got through)
+	double wall_seconds{};
+	LatencyHistogram latency;
+
+	double reads_per_second() const {
+		return wall_seconds > 0 ? static_cast<double>(reads) / wall_seconds : 0;
+	}
+
+	double events_per_second() const {
+		return wall_seconds > 0 ? static_cast<double>(events) / wall_seconds : 0;
+	}
+};
+
+inline FarmLoadReport run_farm_load(DeviceFarm &farm, FarmLoadOptions options) {
+	const std::size_t n = farm.size();
+	Debouncer debouncer(n, options.debounce_polls);
+	std::optional<ThreadPool> own_pool;
+	ThreadPool &pool = options.threads == 0 ? ThreadPool::current() : own_pool.emplace(options.threads);
+	std::mutex merge_mutex;
+	FarmLoadReport report;
+	report.devices = n;
+	report.threads = pool.size();
+	std::atomic<std::uint64_t> events{ 0 }, spurious{ 0 };
+
+	constexpr std::size_t block = 4096;
+	const auto start = std::chrono::steady_clock::now();
+	for (std::size_t round = 1; round <= options.rounds; ++round) {
+		const auto now = static_cast<std::uint32_t>(round * options.poll_interval_us);
+		farm.set_time(now);
+		parallel_for((n + block - 1) / block, 1, [&](std::size_t bb, std::size_t be) {
+			std::array<std::uint8_t, block> raw, changed;
+			std::array<std::uint32_t, block> read_latency;
+			LatencyHistogram local;
+			std::uint64_t local_events = 0, local_spurious = 0;
+			for (std::size_t blk = bb; blk < be; ++blk) {
+				const std::size_t first = blk * block, count = std::min(block, n - first);
+				if (options.path == PollPath::button) {
+					for (std::size_t k = 0; k < count; ++k) {
+						auto input = farm.input(first + k);
+						ButtonWithConcept<DeviceFarm::Input> button(&input);
+						raw[k] = static_cast<std::uint8_t>(button.read());
+						read_latency[k] = input.last_latency_us();
+					}
+				}
+				else {
+					for (std::size_t k = 0; k < count; ++k) {
+						const auto s = farm.sample(first + k);
+						raw[k] = s.level;
+						read_latency[k] = s.latency_us;
+					}
+				}
+				debouncer.update(first, std::span(raw.data(), count), std::span(changed.data(), count));
+				for (std::size_t k = 0; k < count; ++k) {
+					if (changed[k] == 0) {
+						continue;
+					}
+					++local_events;
+					const std::size_t device = first + k;
+					if (debouncer.level(device) != farm.true_level(device)) {
+						++local_spurious;
+					}
+					else if (farm.last_toggle_us(device) != 0) {
+						local.add(now + read_latency[k] - farm.last_toggle_us(device));
+					}
+				}
+			}
+			events += local_events;
+			spurious += local_spurious;
+			std::lock_guard lock(merge_mutex);
+			report.latency.merge(local);
+		}, pool);
+	}
+	report.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report.reads = static_cast<std::uint64_t>(n) * options.rounds;
+	report.events = events;
+	report.spurious_events = spurious;
+	return report;
+}
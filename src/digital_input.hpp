@@ -0,0 +1,141 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+// The SFINAE half of this header is C++17 (the firmware build includes it); the concept half needs C++20.
+#if defined(__cpp_concepts)
+#include <concepts>
+#endif
+
+//================================
+// 			DIGITAL INPUT
+//================================
+// --------- GENERAL --------- 
+class DigitalIn { // This is NOT used, it acts as reference to be "followed" by Mocks without doing polimorphism, enforced by Concept & SFINAE based trait detection (by creating custom type traits)
+public:
+	void init();
+	int read();
+};
+
+class MockedDigitalInput {
+public:
+	void init() {}
+	int read() { return value_; }
+
+	void set_value(int v) { value_ = v; }
+private:
+	int value_{};
+};
+
+class MalformedDigitalInput { /* no init(), no read() */ };
+
+// --------- SFINAE --------- 
+// Old Sfinae (C++11)
+template<typename T>
+class is_digital_input_old_sfinae_type_trait {
+private:
+	template<typename U>
+	static auto test_init(int) -> decltype(std::declval<U>().init(), std::true_type{});
+	
+	template<typename U>
+	static auto test_init(...) -> std::false_type;
+
+	template<typename U>
+	static auto test_read(int) -> decltype(std::declval<U>().read(), std::true_type{});
+	
+	template<typename U>
+	static auto test_read(...) -> std::false_type;
+
+public:
+	static constexpr bool value =
+		decltype(test_init<T>(0))::value &&
+		decltype(test_read<T>(0))::value;
+};
+
+// Newer Sfinae (C++17)
+template<typename T, typename = void>
+struct is_digital_input_new_sfinae_type_trait : std::false_type {};
+
+template<typename T>
+struct is_digital_input_new_sfinae_type_trait<T, std::void_t<
+    decltype(std::declval<T>().init()),
+    decltype(std::declval<T>().read())
+>> : std::true_type {};
+
+template<typename T>
+constexpr bool is_digital_input_new_sfinae_type_trait_v = is_digital_input_new_sfinae_type_trait<T>::value;
+
+// Concepts (C++20)
+#if defined(__cpp_concepts)
+template<typename T>
+concept digital_input_concept = requires(T t) { t.init(); t.read(); };
+#endif
+
+// ---- 1. C++11 ---- 
+// template <typename DIn, typename = std::enable_if_t<is_digital_input_old_sfinae_type_trait<DIn>::value>>
+// class ButtonWithSfinae {
+//     static_assert(is_digital_input_old_sfinae_type_trait<DIn>::value, 
+//                   "DIn must have init() and read() methods");
+
+// ---- 2. C++17 (only static_assert) ---- 
+// template <typename DIn>
+// class ButtonWithSfinae {
+//     static_assert(std::is_same_v<decltype(std::declval<DIn>().init()), void> &&
+//                   std::is_same_v<decltype(std::declval<DIn>().read()), int>, 
+//                   "DIn must have init() and read() methods");
+
+// ---- 3. C++17 (only static_assert type trait) ---- 
+// template <typename DIn>
+// class ButtonWithSfinae {
+//     static_assert(is_digital_input_new_sfinae_type_trait_v<DIn>, 
+//                   "DIn must have init() and read() methods");
+
+// ---- 4. C++17 (Sfinae + type trait) ---- 
+template <typename DIn, typename = std::enable_if_t<is_digital_input_new_sfinae_type_trait_v<DIn>>>
+class ButtonWithSfinae {
+    static_assert(is_digital_input_new_sfinae_type_trait_v<DIn>, 
+                  "DIn must have init() and read() methods");
+
+// ---- 5. C++20 ---- 
+// template <digital_input_concept DIn>
+// class ButtonWithSfinae {
+public:
+	ButtonWithSfinae(DIn *input) : digitalInput_(input) {}
+
+	void init() {
+		digitalInput_->init();
+		// rest of logic...
+	}
+
+	int read() {
+		return digitalInput_->read();
+	}
+
+private:	
+	DIn *digitalInput_;
+};
+
+#if defined(__cpp_concepts)
+// --------- CONCEPT --------- 
+template <typename T>
+concept DigitalInputConcept = requires {
+	{ std::declval<T>().init() } -> std::same_as<void>;
+	{ std::declval<T>().read() } -> std::same_as<int>;
+};
+
+template<DigitalInputConcept DIn>
+class ButtonWithConcept {
+public:
+	ButtonWithConcept(DIn* input): digitalInput_(input) {}
+	void init() {
+		digitalInput_->init();
+		// rest of logic...
+	}
+	int read() {
+		return digitalInput_->read();
+	}
+private:
+	DIn *digitalInput_;
+};
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "debounce.hpp"
+#include "digital_input.hpp"
+#include "vec3.hpp"
+#include "vec3_kernels.hpp"
+
+//================================
+// 			SFINAE FAST PATHS
+//================================
+// C++17 entry points for the firmware toolchain, constrained the way ButtonWithSfinae is (a void_t detection
+// trait plus enable_if) where the C++20 API uses concepts and std::span. They take any contiguous buffer with
+// data() and size() (std::vector, std::array, ...) and call the same kernels as the C++20 API. They are
+// single-threaded: the thread pool needs C++20 (jthread, atomic wait), and the firmware targets have one core.
+//
+// This header must stay C++17; CMake builds src/fast_paths_sfinae_check.cpp in that dialect to keep it so.
+
+// --------- TRAITS ---------
+// C has data() and size(), and data() converts to T* (T may be const-qualified).
+template<typename C, typename T, typename = void>
+struct is_contiguous_buffer_type_trait : std::false_type {};
+
+template<typename C, typename T>
+struct is_contiguous_buffer_type_trait<C, T, std::void_t<
+	decltype(std::declval<C &>().data()),
+	decltype(std::declval<C &>().size())
+>> : std::is_convertible<decltype(std::declval<C &>().data()), T *> {};
+
+template<typename C, typename T>
+constexpr bool is_contiguous_buffer_type_trait_v = is_contiguous_buffer_type_trait<C, T>::value;
+
+// C is a contiguous buffer of digital inputs (by is_digital_input_new_sfinae_type_trait).
+template<typename C, typename = void>
+struct is_digital_input_buffer_type_trait : std::false_type {};
+
+template<typename C>
+struct is_digital_input_buffer_type_trait<C, std::void_t<
+	decltype(std::declval<C &>().data()),
+	decltype(std::declval<C &>().size())
+>> : is_digital_input_new_sfinae_type_trait<std::remove_pointer_t<decltype(std::declval<C &>().data())>> {};
+
+template<typename C>
+constexpr bool is_digital_input_buffer_type_trait_v = is_digital_input_buffer_type_trait<C>::value;
+
+// --------- ENTRY POINTS ---------
+namespace cxx17 {
+
+// One read() per input into levels (0 / 1).
+template<typename Inputs, typename Levels,
+		 typename = std::enable_if_t<is_digital_input_buffer_type_trait_v<Inputs> &&
+									 is_contiguous_buffer_type_trait_v<Levels, std::uint8_t>>>
+void poll_inputs(Inputs &inputs, Levels &levels) {
+	assert(levels.size() >= inputs.size());
+	::poll_inputs(inputs.data(), inputs.size(), levels.data());
+}
+
+// Debouncer::update for devices first .. first + raw.size().
+template<typename Raw, typename Changed,
+		 typename = std::enable_if_t<is_contiguous_buffer_type_trait_v<const Raw, const std::uint8_t> &&
+									 is_contiguous_buffer_type_trait_v<Changed, std::uint8_t>>>
+void debounce(Debouncer &debouncer, std::size_t first, const Raw &raw, Changed &changed) {
+	assert(changed.size() >= raw.size());
+	debouncer.update(first, raw.data(), raw.size(), changed.data());
+}
+
+template<typename Points, typename = std::enable_if_t<is_contiguous_buffer_type_trait_v<Points, Vec3>>>
+void transform_points(const Affine3 &a, Points &points) {
+	transform_detail::transform_aos(a, points.data(), points.size());
+}
+
+inline void transform_points(const Affine3 &a, Vec3SoA &points) {
+	assert(points.y.size() == points.size() && points.z.size() == points.size());
+	transform_detail::transform_soa(a, points.x.data(), points.y.data(), points.z.data(), points.size());
+}
+
+// Full distance matrix: out[i * b.size() + j] = |a[i] - b[j]|^2.
+template<typename A, typename B, typename Out,
+		 typename = std::enable_if_t<is_contiguous_buffer_type_trait_v<const A, const Vec3> &&
+									 is_contiguous_buffer_type_trait_v<const B, const Vec3> &&
+									 is_contiguous_buffer_type_trait_v<Out, float>>>
+void pairwise_sq_distances(const A &a, const B &b, Out &out) {
+	using namespace distance_detail;
+	assert(out.size() == a.size() * b.size());
+	SoATile tile;
+	for (std::size_t task = 0; task < task_count(a.size(), b.size()); ++task) {
+		distance_task(a.data(), a.size(), b.data(), b.size(), task, tile, out.data());
+	}
+}
+
+} // namespace cxx17
@@ -0,0 +1,30 @@
+// Built as C++17 (see CMakeLists.txt) so the firmware entry points, and every header under them, keep compiling in
+// that dialect. Nothing here runs; main.cpp checks the results against the C++20 API.
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "fast_paths_sfinae.hpp"
+
+static_assert(is_digital_input_buffer_type_trait_v<std::vector<MockedDigitalInput>>);
+static_assert(!is_digital_input_buffer_type_trait_v<std::vector<MalformedDigitalInput>>);
+static_assert(!is_digital_input_buffer_type_trait_v<const std::vector<MockedDigitalInput>>);
+static_assert(is_contiguous_buffer_type_trait_v<std::array<Vec3, 4>, Vec3>);
+static_assert(!is_contiguous_buffer_type_trait_v<const std::vector<float>, float>);
+
+void fast_paths_sfinae_check() {
+	std::vector<MockedDigitalInput> inputs(64);
+	std::vector<std::uint8_t> levels(inputs.size()), changed(inputs.size());
+	Debouncer debouncer(inputs.size());
+	cxx17::poll_inputs(inputs, levels);
+	cxx17::debounce(debouncer, 0, levels, changed);
+
+	std::array<Vec3, 4> points{};
+	Vec3SoA soa;
+	soa.resize(4);
+	cxx17::transform_points(Affine3::identity(), points);
+	cxx17::transform_points(Affine3::identity(), soa);
+
+	std::vector<float> distances(points.size() * points.size());
+	cxx17::pairwise_sq_distances(points, points, distances);
+}
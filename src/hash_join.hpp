@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parallel.hpp"
+#include "string_hash.hpp"
+#include "user.hpp"
+#include "user_columns.hpp"
+
+//================================
+// 			HASH JOIN
+//================================
+// Equi-join of two UserTypeConcept collections on username or email. Both sides are hashed once, then
+// radix-partitioned on the top hash bits so every partition's build table stays cache resident; partitions
+// are built and probed independently across the pool. Duplicate keys on either side produce every pair.
+//
+//     auto missing = hash_join(source, directory, JoinKey::email, JoinKind::anti); // in source, not in directory
+enum class JoinKey { username, email };
+
+enum class JoinKind {
+	inner, // one match per equal-key pair
+	left,  // inner, plus (left, no_match) for every left row without a partner
+	anti,  // only (left, no_match) for left rows without a partner
+};
+
+struct JoinMatch {
+	static constexpr std::size_t no_match = std::numeric_limits<std::size_t>::max();
+
+	std::size_t left;
+	std::size_t right;
+
+	friend bool operator==(const JoinMatch &, const JoinMatch &) = default;
+};
+
+namespace join_detail {
+
+// Key of every row as a string_view; fields that only convert to std::string are copied into `owned`.
+struct KeyColumn {
+	std::vector<std::string> owned;
+	std::vector<std::string_view> keys;
+	std::vector<std::uint64_t> hashes;
+};
+
+template<std::ranges::random_access_range R>
+KeyColumn key_column(const R &users, JoinKey key) {
+	using T = std::ranges::range_value_t<R>;
+	const std::size_t n = std::ranges::size(users);
+	KeyColumn column;
+	column.keys.resize(n);
+	column.hashes.resize(n);
+	auto field = [key](const T &user) -> decltype(auto) {
+		return key == JoinKey::username ? user_columns_detail::as_string_view(user.username)
+										: user_columns_detail::as_string_view(user.email);
+	};
+	if constexpr (std::same_as<decltype(field(std::declval<const T &>())), std::string_view>) {
+		for (std::size_t i = 0; i < n; ++i) {
+			column.keys[i] = field(std::ranges::begin(users)[i]);
+		}
+	}
+	else {
+		column.owned.reserve(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			column.owned.push_back(field(std::ranges::begin(users)[i]));
+		}
+		std::ranges::copy(column.owned, column.keys.begin());
+	}
+	parallel_for(n, 16 * 1024, [&](std::size_t b, std::size_t e) {
+		string_hash::hash_batch(std::span(column.keys).subspan(b, e - b), std::span(column.hashes).subspan(b, e - b));
+	});
+	return column;
+}
+
+struct Entry {
+	std::uint64_t hash;
+	std::size_t row;
+};
+
+// Rows scattered into 2^bits partitions by the top bits of their hash; partition p is
+// entries[offsets[p] .. offsets[p + 1]).
+struct Partitioned {
+	std::vector<Entry> entries;
+	std::vector<std::size_t> offsets;
+};
+
+inline Partitioned partition(std::span<const std::uint64_t> hashes, int bits) {
+	constexpr std::size_t grain = 64 * 1024;
+	const std::size_t n = hashes.size();
+	const std::size_t parts = std::size_t{ 1 } << bits;
+	auto part_of = [bits](std::uint64_t h) {
+		return bits == 0 ? std::size_t{ 0 } : static_cast<std::size_t>(h >> (64 - bits));
+	};
+
+	const std::size_t chunks = std::clamp<std::size_t>(n / grain, 1, ThreadPool::current().size());
+	const std::size_t chunk = (n + chunks - 1) / chunks;
+	std::vector<std::vector<std::size_t>> hist(chunks, std::vector<std::size_t>(parts));
+	parallel_for(chunks, 1, [&](std::size_t cb, std::size_t ce) {
+		for (std::size_t c = cb; c < ce; ++c) {
+			for (std::size_t i = c * chunk, end = std::min(n, (c + 1) * chunk); i < end; ++i) {
+				++hist[c][part_of(hashes[i])];
+			}
+		}
+	});
+
+	// partition-major then chunk-major, so each partition keeps input order
+	Partitioned out;
+	out.offsets.resize(parts + 1);
+	std::size_t sum = 0;
+	for (std::size_t p = 0; p < parts; ++p) {
+		out.offsets[p] = sum;
+		for (std::size_t c = 0; c < chunks; ++c) {
+			const std::size_t count = hist[c][p];
+			hist[c][p] = sum;
+			sum += count;
+		}
+	}
+	out.offsets[parts] = sum;
+
+	out.entries.resize(n);
+	parallel_for(chunks, 1, [&](std::size_t cb, std::size_t ce) {
+		for (std::size_t c = cb; c < ce; ++c) {
+			auto &cursor = hist[c];
+			for (std::size_t i = c * chunk, end = std::min(n, (c + 1) * chunk); i < end; ++i) {
+				out.entries[cursor[part_of(hashes[i])]++] = { hashes[i], i };
+			}
+		}
+	});
+	return out;
+}
+
+// Enough partitions that one build partition's table (~16 bytes per row at 50% load) fits in L2.
+inline int partition_bits(std::size_t build_rows) {
+	constexpr std::size_t rows_per_partition = 8 * 1024;
+	const std::size_t parts = std::bit_ceil(std::max<std::size_t>(build_rows / rows_per_partition, 1));
+	return std::min(std::countr_zero(parts), 12);
+}
+
+// Joins one partition pair. The table is open addressing with linear probing over build entries; the low hash
+// bits pick the slot because the high bits are the same for the whole partition.
+inline void join_partition(std::span<const Entry> build, std::span<const Entry> probe, const KeyColumn &build_keys,
+						   const KeyColumn &probe_keys, JoinKind kind, std::vector<JoinMatch> &out) {
+	constexpr std::uint32_t empty = std::numeric_limits<std::uint32_t>::max();
+	const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(build.size() * 2, 16));
+	const std::size_t mask = capacity - 1;
+	std::vector<std::uint32_t> slots(capacity, empty);
+	for (std::size_t i = 0; i < build.size(); ++i) {
+		std::size_t s = build[i].hash & mask;
+		while (slots[s] != empty) {
+			s = (s + 1) & mask;
+		}
+		slots[s] = static_cast<std::uint32_t>(i);
+	}
+
+	for (const Entry &row : probe) {
+		const std::string_view key = probe_keys.keys[row.row];
+		bool matched = false;
+		for (std::size_t s = row.hash & mask; slots[s] != empty; s = (s + 1) & mask) {
+			const Entry &candidate = build[slots[s]];
+			if (candidate.hash == row.hash && build_keys.keys[candidate.row] == key) {
+				matched = true;
+				if (kind == JoinKind::anti) {
+					break;
+				}
+				out.push_back({ row.row, candidate.row });
+			}
+		}
+		if (!matched && kind != JoinKind::inner) {
+			out.push_back({ row.row, JoinMatch::no_match });
+		}
+	}
+}
+
+} // namespace join_detail
+
+// Matches of `left` rows against `right` rows with equal keys. The right side is the one hashed into tables, so
+// pass the smaller collection there when the join kind allows it. Output is grouped by partition, not sorted.
+template<std::ranges::random_access_range L, std::ranges::random_access_range R>
+	requires UserTypeConcept<std::ranges::range_value_t<L>> && UserTypeConcept<std::ranges::range_value_t<R>>
+std::vector<JoinMatch> hash_join(const L &left, const R &right, JoinKey key, JoinKind kind = JoinKind::inner) {
+	const auto probe_keys = join_detail::key_column(left, key);
+	const auto build_keys = join_detail::key_column(right, key);
+	if (build_keys.keys.size() >= std::numeric_limits<std::uint32_t>::max()) {
+		throw std::length_error("hash_join: right side exceeds 4G rows");
+	}
+
+	const int bits = join_detail::partition_bits(build_keys.keys.size());
+	const auto probe = join_detail::partition(probe_keys.hashes, bits);
+	const auto build = join_detail::partition(build_keys.hashes, bits);
+
+	const std::size_t parts = probe.offsets.size() - 1;
+	std::vector<std::vector<JoinMatch>> results(parts);
+	parallel_for(parts, 1, [&](std::size_t pb, std::size_t pe) {
+		for (std::size_t p = pb; p < pe; ++p) {
+			auto slice = [p](const join_detail::Partitioned &side) {
+				return std::span(side.entries).subspan(side.offsets[p], side.offsets[p + 1] - side.offsets[p]);
+			};
+			join_detail::join_partition(slice(build), slice(probe), build_keys, probe_keys, kind, results[p]);
+		}
+	});
+
+	std::size_t total = 0;
+	for (const auto &r : results) {
+		total += r.size();
+	}
+	std::vector<JoinMatch> matches;
+	matches.reserve(total);
+	for (const auto &r : results) {
+		matches.insert(matches.end(), r.begin(), r.end());
+	}
+	return matches;
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "parallel.hpp"
+#include "vec3.hpp"
+
+//================================
+// 			KD TREE
+//================================
+// Static k-d tree over a point span, built once with median splits and queried many times.
+// Nodes are 16 bytes in depth-first order (left child directly follows its parent), and the points are
+// copied into per-leaf SoA runs so a leaf test is one streaming distance loop over x[], y[], z[].
+class KdTree {
+public:
+	static constexpr std::size_t max_leaf_size = 32;
+
+	struct Neighbor {
+		std::uint32_t index; // position in the span the tree was built from
+		float dist2;
+	};
+
+	explicit KdTree(std::span<const Vec3> points, std::size_t leaf_size = 8)
+		: leaf_size_(std::clamp<std::size_t>(leaf_size, 1, max_leaf_size)) {
+		assert(points.size() < std::numeric_limits<std::uint32_t>::max());
+		const auto n = static_cast<std::uint32_t>(points.size());
+		if (n == 0) {
+			return;
+		}
+
+		ids_.resize(n);
+		std::iota(ids_.begin(), ids_.end(), 0u);
+		nodes_.resize(subtree_nodes(n));
+		build(points, 0, 0, n, 0);
+
+		xs_.resize(n);
+		ys_.resize(n);
+		zs_.resize(n);
+		parallel_for(n, 64 * 1024, [&](std::size_t b, std::size_t e) {
+			for (std::size_t i = b; i < e; ++i) {
+				const Vec3 p = points[ids_[i]];
+				xs_[i] = p.e0;
+				ys_[i] = p.e1;
+				zs_[i] = p.e2;
+			}
+		});
+	}
+
+	std::size_t size() const {
+		return ids_.size();
+	}
+
+	std::size_t node_count() const {
+		return nodes_.size();
+	}
+
+	// Closest point to q. The tree must not be empty.
+	Neighbor nearest(const Vec3 q) const {
+		assert(!ids_.empty());
+		Neighbor best { 0, std::numeric_limits<float>::infinity() };
+		nearest(0, q, best);
+		return best;
+	}
+
+	// The k closest points to q, nearest first.
+	void knn(const Vec3 q, std::size_t k, std::vector<Neighbor> &out) const {
+		out.clear();
+		if (k == 0 || ids_.empty()) {
+			return;
+		}
+		out.reserve(k);
+		knn(0, q, k, out);
+		std::sort_heap(out.begin(), out.end(), farther);
+	}
+
+	// Every point within `radius` of q, in no particular order.
+	void radius_search(const Vec3 q, float radius, std::vector<Neighbor> &out) const {
+		out.clear();
+		if (!ids_.empty()) {
+			radius_search(0, q, radius * radius, out);
+		}
+	}
+
+	// nearest() for a whole batch, spread across the thread pool.
+	void nearest_batch(std::span<const Vec3> queries, std::span<Neighbor> out) const {
+		assert(queries.size() == out.size());
+		parallel_for(queries.size(), 1024, [&](std::size_t b, std::size_t e) {
+			for (std::size_t i = b; i < e; ++i) {
+				out[i] = nearest(queries[i]);
+			}
+		});
+	}
+
+private:
+	struct Node {
+		float split;
+		std::uint32_t axis;  // 0..2 for inner nodes, leaf_axis for leaves
+		std::uint32_t first; // inner: unused; leaf: first point in xs_/ys_/zs_
+		std::uint32_t right; // inner: index of the right child; leaf: number of points
+	};
+	static_assert(sizeof(Node) == 16);
+	static constexpr std::uint32_t leaf_axis = 3;
+
+	static bool farther(const Neighbor &a, const Neighbor &b) {
+		return a.dist2 < b.dist2; // max-heap on distance: the worst kept neighbor sits at the front
+	}
+
+	// Node count of a subtree over n points; fixed by the median split, which lets siblings build in parallel.
+	std::size_t subtree_nodes(std::size_t n) const {
+		return subtree_nodes_pair(n).first;
+	}
+
+	// {nodes(n), nodes(n + 1)}: both halves of n and n + 1 are m or m + 1 with m = n / 2, so this is O(log n).
+	std::pair<std::size_t, std::size_t> subtree_nodes_pair(std::size_t n) const {
+		if (n + 1 <= leaf_size_) {
+			return { 1, 1 };
+		}
+		auto [a, b] = subtree_nodes_pair(n / 2);
+		const bool even = n % 2 == 0;
+		const std::size_t nodes_n = n <= leaf_size_ ? 1 : even ? 1 + 2 * a : 1 + a + b;
+		const std::size_t nodes_n1 = even ? 1 + a + b : 1 + 2 * b;
+		return { nodes_n, nodes_n1 };
+	}
+
+	void build(std::span<const Vec3> points, std::uint32_t node, std::uint32_t begin, std::uint32_t end, int depth) {
+		const std::uint32_t count = end - begin;
+		if (count <= leaf_size_) {
+			nodes_[node] = { 0.0f, leaf_axis, begin, count };
+			return;
+		}
+
+		Aabb box;
+		for (std::uint32_t i = begin; i < end; ++i) {
+			box.extend(points[ids_[i]]);
+		}
+		const float extent[3] = { box.hi.e0 - box.lo.e0, box.hi.e1 - box.lo.e1, box.hi.e2 - box.lo.e2 };
+		const std::uint32_t axis = static_cast<std::uint32_t>(std::max_element(extent, extent + 3) - extent);
+		auto coord = [&](std::uint32_t id) {
+			return axis == 0 ? points[id].e0 : axis == 1 ? points[id].e1 : points[id].e2;
+		};
+
+		const std::uint32_t mid = begin + count / 2;
+		std::nth_element(ids_.begin() + begin, ids_.begin() + mid, ids_.begin() + end,
+						 [&](std::uint32_t a, std::uint32_t b) { return coord(a) < coord(b); });
+
+		const auto left = node + 1;
+		const auto right = static_cast<std::uint32_t>(left + subtree_nodes(mid - begin));
+		nodes_[node] = { coord(ids_[mid]), axis, 0, right };
+
+		// the top few levels fan out over the pool; below that there is enough parallel work already
+		if (depth < 6 && count > 32 * 1024) {
+			parallel_for(2, 1, [&](std::size_t b, std::size_t e) {
+				for (std::size_t side = b; side < e; ++side) {
+					side == 0 ? build(points, left, begin, mid, depth + 1) : build(points, right, mid, end, depth + 1);
+				}
+			});
+		}
+		else {
+			build(points, left, begin, mid, depth + 1);
+			build(points, right, mid, end, depth + 1);
+		}
+	}
+
+	// Squared distances from q to the points [first, first + count) of a leaf.
+	void leaf_distances(const Vec3 q, std::uint32_t first, std::uint32_t count, float *out) const {
+		const float *x = xs_.data() + first;
+		const float *y = ys_.data() + first;
+		const float *z = zs_.data() + first;
+		std::uint32_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+		const __m256 qx = _mm256_set1_ps(q.e0), qy = _mm256_set1_ps(q.e1), qz = _mm256_set1_ps(q.e2);
+		for (; i + 8 <= count; i += 8) {
+			__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), qx);
+			__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), qy);
+			__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + i), qz);
+			__m256 d = _mm256_mul_ps(dx, dx);
+			d = _mm256_fmadd_ps(dy, dy, d);
+			d = _mm256_fmadd_ps(dz, dz, d);
+			_mm256_storeu_ps(out + i, d);
+		}
+#endif
+		for (; i < count; ++i) {
+			const float dx = x[i] - q.e0, dy = y[i] - q.e1, dz = z[i] - q.e2;
+			out[i] = dx * dx + dy * dy + dz * dz;
+		}
+	}
+
+	static float axis_value(const Vec3 q, std::uint32_t axis) {
+		return axis == 0 ? q.e0 : axis == 1 ? q.e1 : q.e2;
+	}
+
+	void nearest(std::uint32_t index, const Vec3 q, Neighbor &best) const {
+		const Node &node = nodes_[index];
+		if (node.axis == leaf_axis) {
+			float d[max_leaf_size];
+			leaf_distances(q, node.first, node.right, d);
+			for (std::uint32_t i = 0; i < node.right; ++i) {
+				if (d[i] < best.dist2) {
+					best = { ids_[node.first + i], d[i] };
+				}
+			}
+			return;
+		}
+		const float delta = axis_value(q, node.axis) - node.split;
+		const std::uint32_t near = delta < 0 ? index + 1 : node.right;
+		const std::uint32_t far = delta < 0 ? node.right : index + 1;
+		nearest(near, q, best);
+		if (delta * delta < best.dist2) {
+			nearest(far, q, best);
+		}
+	}
+
+	void knn(std::uint32_t index, const Vec3 q, std::size_t k, std::vector<Neighbor> &heap) const {
+		const Node &node = nodes_[index];
+		if (node.axis == leaf_axis) {
+			float d[max_leaf_size];
+			leaf_distances(q, node.first, node.right, d);
+			for (std::uint32_t i = 0; i < node.right; ++i) {
+				if (heap.size() < k) {
+					heap.push_back({ ids_[node.first + i], d[i] });
+					std::push_heap(heap.begin(), heap.end(), farther);
+				}
+				else if (d[i] < heap.front().dist2) {
+					std::pop_heap(heap.begin(), heap.end(), farther);
+					heap.back() = { ids_[node.first + i], d[i] };
+					std::push_heap(heap.begin(), heap.end(), farther);
+				}
+			}
+			return;
+		}
+		const float delta = axis_value(q, node.axis) - node.split;
+		const std::uint32_t near = delta < 0 ? index + 1 : node.right;
+		const std::uint32_t far = delta < 0 ? node.right : index + 1;
+		knn(near, q, k, heap);
+		if (heap.size() < k || delta * delta < heap.front().dist2) {
+			knn(far, q, k, heap);
+		}
+	}
+
+	void radius_search(std::uint32_t index, const Vec3 q, float r2, std::vector<Neighbor> &out) const {
+		const Node &node = nodes_[index];
+		if (node.axis == leaf_axis) {
+			float d[max_leaf_size];
+			leaf_distances(q, node.first, node.right, d);
+			for (std::uint32_t i = 0; i < node.right; ++i) {
+				if (d[i] <= r2) {
+					out.push_back({ ids_[node.first + i], d[i] });
+				}
+			}
+			return;
+		}
+		const float delta = axis_value(q, node.axis) - node.split;
+		const std::uint32_t near = delta < 0 ? index + 1 : node.right;
+		const std::uint32_t far = delta < 0 ? node.right : index + 1;
+		radius_search(near, q, r2, out);
+		if (delta * delta <= r2) {
+			radius_search(far, q, r2, out);
+		}
+	}
+
+	std::size_t leaf_size_;
+	std::vector<Node> nodes_;
+	std::vector<std::uint32_t> ids_;
+	std::vector<float> xs_, ys_, zs_;
+};
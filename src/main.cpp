@@ -1,8 +1,41 @@
+#include <algorithm>
 #include <concepts>
 #include <iostream>
 #include <type_traits>
+#include <unordered_set>
 #include <print>
-#include <cassert>
+#include <random>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+#include "vec3.hpp"
+#include "user.hpp"
+#include "digital_input.hpp"
+#include "point_cloud_io.hpp"
+#include "vec3_pipeline.hpp"
+#include "morton.hpp"
+#include "kd_tree.hpp"
+#include "voxel_grid.hpp"
+#include "pairwise_distance.hpp"
+#include "quaternion.hpp"
+#include "arrow_ipc.hpp"
+#include "user_query.hpp"
+#include "string_hash.hpp"
+#include "hash_join.hpp"
+#include "snapshot_diff.hpp"
+#include "serialize.hpp"
+#include "test_registry.hpp"
+#include "bench_stats.hpp"
+#include "device_farm.hpp"
+#include "memory_footprint.hpp"
+#include "startup_profile.hpp"
+#include "fast_paths_sfinae.hpp"
+#include "sharded_counters.hpp"
+#include "summation.hpp"
+#include "simd_sort.hpp"
+#include "sorted_set.hpp"
+#include "roaring_bitmap.hpp"
 
 //================================
 // 			FOO CHECK
@@ -67,13 +100,7 @@ T add3(T a, T b) {
 	return a + b;
 }
 
-struct Vec3 {
-	float e0;
-	float e1;
-	float e2;
-};
-
-// add each vector member with a scalar
+// add each vector member with a scalar (Vec3 itself lives in vec3.hpp)
 Vec3 operator+(const Vec3 v, std::integral auto s) {
 	return Vec3 { .e0 = v.e0 + s, .e1 = v.e1 + s, .e2 = v.e2 + s };
 }
@@ -90,25 +117,6 @@ concept C = requires(T p[2])
 
 static_assert(C<int*>); // checking if int* satisfies the expression
 
-struct User {
-	std::string username;
-	std::string email;
-};
-
-
-template<typename T>
-concept UserTypeConcept = 
-	requires(T t) {
-		{ t.username } -> std::convertible_to<std::string>;
-		/*
-			- requires is the definition / identity of the constraint that concept will use
-			- bagian kiri bisa dibaca: { t.username } results in std::string&, which is a reference to User::username
-			- bagian kanan bisa dibaca: std::convertible_to<std::string&, std::string>;
-		*/
-	} && requires {
-		{ std::declval<T>().email } -> std::convertible_to<std::string>;
-	};
-
 template<typename T>
 concept UserTypeDeclValConcept = requires {
 	{ std::declval<T>().username } -> std::convertible_to<std::string>;
@@ -126,108 +134,7 @@ static_assert(std::same_as<int, int>);
 //================================
 // 			MOCKING
 //================================
-// --------- GENERAL --------- 
-class DigitalIn { // This is NOT used, it acts as reference to be "followed" by Mocks without doing polimorphism, enforced by Concept & SFINAE based trait detection (by creating custom type traits)
-public:
-	void init();
-	int read();
-};
-
-class MockedDigitalInput {
-public:
-	void init() {}
-	int read() { return value_; }
-
-	void set_value(int v) { value_ = v; }
-private:
-	int value_{};
-};
-
-class MalformedDigitalInput { /* no init(), no read() */ };
-
-// --------- SFINAE --------- 
-// Old Sfinae (C++11)
-template<typename T>
-class is_digital_input_old_sfinae_type_trait {
-private:
-	template<typename U>
-	static auto test_init(int) -> decltype(std::declval<U>().init(), std::true_type{});
-	
-	template<typename U>
-	static auto test_init(...) -> std::false_type;
-
-	template<typename U>
-	static auto test_read(int) -> decltype(std::declval<U>().read(), std::true_type{});
-	
-	template<typename U>
-	static auto test_read(...) -> std::false_type;
-
-public:
-	static constexpr bool value =
-		decltype(test_init<T>(0))::value &&
-		decltype(test_read<T>(0))::value;
-};
-
-// Newer Sfinae (C++17)
-template<typename T, typename = void>
-struct is_digital_input_new_sfinae_type_trait : std::false_type {};
-
-template<typename T>
-struct is_digital_input_new_sfinae_type_trait<T, std::void_t<
-    decltype(std::declval<T>().init()),
-    decltype(std::declval<T>().read())
->> : std::true_type {};
-
-template<typename T>
-constexpr bool is_digital_input_new_sfinae_type_trait_v = is_digital_input_new_sfinae_type_trait<T>::value;
-
-// Concepts (C++20)
-template<typename T>
-concept digital_input_concept = requires(T t) { t.init(); t.read(); };
-
-// ---- 1. C++11 ---- 
-// template <typename DIn, typename = std::enable_if_t<is_digital_input_old_sfinae_type_trait<DIn>::value>>
-// class ButtonWithSfinae {
-//     static_assert(is_digital_input_old_sfinae_type_trait<DIn>::value, 
-//                   "DIn must have init() and read() methods");
-
-// ---- 2. C++17 (only static_assert) ---- 
-// template <typename DIn>
-// class ButtonWithSfinae {
-//     static_assert(std::is_same_v<decltype(std::declval<DIn>().init()), void> &&
-//                   std::is_same_v<decltype(std::declval<DIn>().read()), int>, 
-//                   "DIn must have init() and read() methods");
-
-// ---- 3. C++17 (only static_assert type trait) ---- 
-// template <typename DIn>
-// class ButtonWithSfinae {
-//     static_assert(is_digital_input_new_sfinae_type_trait_v<DIn>, 
-//                   "DIn must have init() and read() methods");
-
-// ---- 4. C++17 (Sfinae + type trait) ---- 
-template <typename DIn, typename = std::enable_if_t<is_digital_input_new_sfinae_type_trait_v<DIn>>>
-class ButtonWithSfinae {
-    static_assert(is_digital_input_new_sfinae_type_trait_v<DIn>, 
-                  "DIn must have init() and read() methods");
-
-// ---- 5. C++20 ---- 
-// template <digital_input_concept DIn>
-// class ButtonWithSfinae {
-public:
-	ButtonWithSfinae(DIn *input) : digitalInput_(input) {}
-
-	void init() {
-		digitalInput_->init();
-		// rest of logic...
-	}
-
-	int read() {
-		return digitalInput_->read();
-	}
-
-private:	
-	DIn *digitalInput_;
-};
+// DigitalIn, the mocks, the traits and both Button flavours live in digital_input.hpp
 
 void test_button_sfinae() {
 	MockedDigitalInput input;
@@ -235,42 +142,20 @@ void test_button_sfinae() {
 
 	input.set_value(42);
 	std::cout << button.read() << std::endl;
-	assert(button.read() == 42);
+	expect(button.read() == 42);
 }
 
-// --------- CONCEPT --------- 
-template <typename T>
-concept DigitalInputConcept = requires {
-	{ std::declval<T>().init() } -> std::same_as<void>;
-	{ std::declval<T>().read() } -> std::same_as<int>;
-};
-
-template<DigitalInputConcept DIn>
-class ButtonWithConcept {
-public:
-	ButtonWithConcept(DIn* input): digitalInput_(input) {}
-	void init() {
-		digitalInput_->init();
-		// rest of logic...
-	}
-	int read() {
-		return digitalInput_->read();
-	}
-private:
-	DIn *digitalInput_;
-};
-
 void test_button_concept() {
 	MockedDigitalInput input;
 	ButtonWithConcept<MockedDigitalInput> button(&input);
 
 	input.set_value(100);
 	std::println("{}", button.read());
-	assert(button.read() == 100);
+	expect(button.read() == 100);
 }
 
 void test_malformed_button() {
-    MalformedDigitalInput malformedInput;
+    [[maybe_unused]] MalformedDigitalInput malformedInput;
     // ButtonWithSfinae<MalformedDigitalInput> buttonSfin(&malformedInput);  // SFINAE in action! Compile error
     // ButtonWithConcept<MalformedDigitalInput> buttonCon(&malformedInput);  // SFINAE in action! Compile error
 }
@@ -323,26 +208,928 @@ void test_digital_sensor() {
     processSensor(as);  // Uses fallback path
 }
 
+//================================
+// 			POINT CLOUD IO
+//================================
+void test_point_cloud_io() {
+	const ScratchDir dir("point_cloud_io");
+	const Vec3 points[] = { { 1, 2, 3 }, { 4, 5, 6 } };
+
+	// packed float triples map straight onto Vec3
+	{
+		std::ofstream xyz(dir / "points.xyz", std::ios::binary);
+		xyz.write(reinterpret_cast<const char *>(points), sizeof(points));
+	}
+	auto xyz = PointCloudReader::open(dir / "points.xyz");
+	expect(xyz.contiguous() && xyz.points().size() == 2);
+	expect(xyz.points()[1].e2 == 6);
+
+	// a color byte next to x/y/z forces the strided view
+	{
+		std::ofstream ply(dir / "points.ply", std::ios::binary);
+		ply << "ply\nformat binary_little_endian 1.0\nelement vertex 2\n"
+			<< "property float x\nproperty float y\nproperty float z\nproperty uchar red\nend_header\n";
+		for (const Vec3 &p : points) {
+			ply.write(reinterpret_cast<const char *>(&p), sizeof(p));
+			ply.put('\xff');
+		}
+	}
+	auto ply = PointCloudReader::open(dir / "points.ply");
+	expect(!ply.contiguous() && ply.strided().stride() == 13);
+	std::println("ply vertices: {}, last x: {}", ply.size(), ply.strided()[1].e0);
+	expect(ply.strided()[1].e0 == 4);
+
+	// a vertex count whose count * stride wraps around to a few bytes is still truncated data
+	{
+		std::ofstream ply(dir / "wrapped.ply", std::ios::binary);
+		ply << "ply\nformat binary_little_endian 1.0\nelement vertex 1418980313362273202\n"
+			<< "property float x\nproperty float y\nproperty float z\nproperty uchar red\nend_header\n";
+		ply.write(reinterpret_cast<const char *>(points), sizeof(points));
+	}
+	bool truncated = false;
+	try {
+		PointCloudReader::open(dir / "wrapped.ply");
+	}
+	catch (const std::runtime_error &) {
+		truncated = true;
+	}
+	expect(truncated);
+}
+
+//================================
+// 			STREAMING PIPELINE
+//================================
+void test_vec3_pipeline() {
+	const ScratchDir dir("vec3_pipeline");
+	{
+		std::ofstream xyz(dir / "stream_in.xyz", std::ios::binary);
+		for (int i = 0; i < 1000; ++i) {
+			Vec3 p { .e0 = float(i), .e1 = 0, .e2 = 0 };
+			xyz.write(reinterpret_cast<const char *>(&p), sizeof(p));
+		}
+	}
+
+	// tiny blocks so the three stages actually overlap
+	auto offset = stream_transform(dir / "stream_in.xyz", dir / "stream_mid.xyz", [](Vec3 v) { return v + 1; },
+								   PipelineOptions { .chunk_points = 64, .grain = 16 });
+	Affine3 swap_xy { { { 0, 1, 0, 0 }, { 1, 0, 0, 0 }, { 0, 0, 1, 0 } } };
+	stream_transform(dir / "stream_mid.xyz", dir / "stream_out.xyz", swap_xy, PipelineOptions { .chunk_points = 100 });
+	std::println("streamed {} points in {} chunks", offset.points, offset.chunks);
+
+	auto result = PointCloudReader::open(dir / "stream_out.xyz");
+	expect(result.size() == 1000);
+	expect(result.points()[999].e1 == 1000 && result.points()[999].e0 == 1);
+}
+
+//================================
+// 			MORTON ORDER
+//================================
+void test_morton_order() {
+	expect(morton::encode(1, 0, 0) == 0b001 && morton::encode(0, 1, 0) == 0b010 && morton::encode(0, 0, 1) == 0b100);
+	auto cell = morton::decode(morton::encode(123456, 7, morton::axis_max));
+	expect(cell.x == 123456 && cell.y == 7 && cell.z == morton::axis_max);
+
+	// two clusters, interleaved on input
+	std::vector<Vec3> points;
+	for (int i = 0; i < 8; ++i) {
+		float base = i % 2 ? 100.0f : 0.0f;
+		points.push_back({ .e0 = base + i, .e1 = base, .e2 = base });
+	}
+	morton_reorder(points);
+	std::println("morton order: first {}, last {}", points.front().e0, points.back().e0);
+	expect(std::is_sorted(points.begin(), points.end(), [](Vec3 a, Vec3 b) { return a.e0 < b.e0; }));
+}
+
+//================================
+// 			KD TREE
+//================================
+void test_kd_tree() {
+	std::vector<Vec3> grid;
+	for (int x = 0; x < 10; ++x) {
+		for (int y = 0; y < 10; ++y) {
+			grid.push_back({ .e0 = float(x), .e1 = float(y), .e2 = 0 });
+		}
+	}
+	KdTree tree(grid);
+
+	auto nn = tree.nearest({ .e0 = 3.1f, .e1 = 6.8f, .e2 = 0.5f });
+	expect(grid[nn.index].e0 == 3 && grid[nn.index].e1 == 7);
+
+	std::vector<KdTree::Neighbor> found;
+	tree.knn({ .e0 = 0, .e1 = 0, .e2 = 0 }, 3, found);
+	expect(found.size() == 3 && found[0].dist2 == 0 && found[2].dist2 == 1);
+
+	tree.radius_search({ .e0 = 5, .e1 = 5, .e2 = 0 }, 1.0f, found);
+	std::println("kd tree: {} nodes, {} points within 1 of (5,5)", tree.node_count(), found.size());
+	expect(found.size() == 5);
+}
+
+//================================
+// 			VOXEL GRID
+//================================
+void test_voxel_grid() {
+	// four points in voxel (0,0,0), one alone in voxel (2,0,0)
+	std::vector<Vec3> points = {
+		{ 0.1f, 0.1f, 0.1f }, { 0.3f, 0.3f, 0.3f }, { 0.1f, 0.3f, 0.1f }, { 0.3f, 0.1f, 0.3f }, { 2.2f, 0.0f, 0.0f },
+	};
+	auto centroids = voxel_downsample(points, { .leaf_size = 1.0f });
+	expect(centroids.size() == 2);
+	expect(std::abs(centroids[0].e0 - 0.2f) < 1e-6f && centroids[1].e0 == 2.2f);
+
+	auto dense = voxel_downsample_soa(points, { .leaf_size = 1.0f, .min_points_per_voxel = 2 });
+	std::println("voxel grid: {} voxels, {} with 2+ points", centroids.size(), dense.size());
+	expect(dense.size() == 1 && std::abs(dense.y[0] - 0.2f) < 1e-6f);
+}
+
+//================================
+// 			PAIRWISE DISTANCE
+//================================
+void test_pairwise_distance() {
+	std::vector<Vec3> a = { { 0, 0, 0 }, { 10, 0, 0 } };
+	std::vector<Vec3> b = { { 1, 0, 0 }, { 0, 2, 0 }, { 10, 0, 3 } };
+
+	std::vector<float> d(a.size() * b.size());
+	pairwise_sq_distances(a, b, d);
+	expect(d[0] == 1 && d[1] == 4 && d[2] == 109 && d[5] == 9);
+
+	auto pairs = close_pairs(a, b, 4.0f);
+	std::println("pairwise distance: {} pairs within 2", pairs.size());
+	expect(pairs.size() == 2);
+
+	// 261 x 1030 crosses the 256-row band and two 512-column tiles, with leftover rows and columns on every path;
+	// each element must match the scalar expression bit for bit
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+	auto random_points = [&](std::size_t n) {
+		std::vector<Vec3> points(n);
+		for (auto &p : points) {
+			p = { coord(rng), coord(rng), coord(rng) };
+		}
+		return points;
+	};
+	const auto big_a = random_points(261), big_b = random_points(1030);
+	std::vector<float> big(big_a.size() * big_b.size());
+	pairwise_sq_distances(big_a, big_b, big);
+	std::size_t mismatches = 0;
+	for (std::size_t i = 0; i < big_a.size(); ++i) {
+		for (std::size_t j = 0; j < big_b.size(); ++j) {
+			const float expected = distance_detail::sq_norm(big_b[j].e0 - big_a[i].e0, big_b[j].e1 - big_a[i].e1,
+															big_b[j].e2 - big_a[i].e2);
+			mismatches += big[i * big_b.size() + j] != expected;
+		}
+	}
+	expect(mismatches == 0);
+	// close_pairs walks the same tasks
+	const auto near = close_pairs(big_a, big_b, 25.0f);
+	expect(near.size() == static_cast<std::size_t>(std::ranges::count_if(big, [](float d) { return d <= 25.0f; })));
+	expect(std::ranges::all_of(near, [&](ClosePair p) { return big[p.i * big_b.size() + p.j] == p.dist2; }));
+}
+
+//================================
+// 			QUATERNION
+//================================
+void test_quaternion() {
+	const float quarter_turn = std::acos(0.0f);
+	Quat about_z = Quat::from_axis_angle({ 0, 0, 1 }, quarter_turn);
+
+	Vec3 x_axis = about_z.rotate({ 1, 0, 0 });
+	expect(std::abs(x_axis.e0) < 1e-6f && std::abs(x_axis.e1 - 1) < 1e-6f);
+
+	// 1000 points, not a multiple of the SIMD width, rotated as AoS and as SoA
+	std::vector<Vec3> aos;
+	Vec3SoA soa;
+	for (int i = 0; i < 1000; ++i) {
+		aos.push_back({ .e0 = float(i), .e1 = 1, .e2 = 2 });
+		soa.x.push_back(float(i));
+		soa.y.push_back(1);
+		soa.z.push_back(2);
+	}
+	rotate_points(about_z * about_z, aos);
+	rotate_points(about_z * about_z, soa);
+	std::println("quaternion: (999, 1, 2) -> ({}, {}, {})", aos[999].e0, aos[999].e1, aos[999].e2);
+	expect(std::abs(aos[999].e0 + 999) < 1e-3f && std::abs(aos[999].e1 + 1) < 1e-3f && aos[999].e2 == 2);
+	expect(soa.x[999] == aos[999].e0 && soa.y[999] == aos[999].e1);
+}
+
+//================================
+// 			ARROW COLUMNS
+//================================
+void test_arrow_columns() {
+	std::vector<User> users = {
+		{ .username = "ada", .email = "ada@example.com" },
+		{ .username = "linus", .email = "linus@kernel.org" },
+		{ .username = "grace", .email = "grace@navy.mil" },
+	};
+	const ScratchDir dir("arrow_columns");
+	const auto path = dir / "users.arrow";
+
+	// two rows per batch -> two record batches
+	write_users_arrow(path, users, { .batch_rows = 2 });
+	auto mapped = UserArrowFile::open(path);
+	expect(mapped.rows() == 3 && mapped.batches().size() == 2);
+	expect(mapped.batches()[1].email[0] == "grace@navy.mil");
+
+	auto back = mapped.to_records();
+	std::println("arrow: {} users, last {}", back.size(), back.back().username);
+	expect(back[1].username == "linus" && back[1].email == "linus@kernel.org");
+}
+
+//================================
+// 			USER QUERY
+//================================
+void test_user_query() {
+	UserColumns table = UserColumns::from(std::vector<User> {
+		{ .username = "ada", .email = "ada@example.com" },
+		{ .username = "svc-backup", .email = "backup@corp.example" },
+		{ .username = "adam", .email = "adam@corp.example" },
+		{ .username = "grace", .email = "grace@navy.mil" },
+	});
+	auto columns = table.view();
+
+	using namespace user_query;
+	auto staff = filter(columns, email.domain_in({ "corp.example" }) && !username.starts_with("svc-"));
+	expect(staff.count() == 1 && staff.test(2));
+
+	auto ad_or_navy = filter(columns, username.starts_with("ad") || email.contains("navy"));
+	auto long_names = filter(columns, username.matches([](std::string_view s) { return s.size() > 4; }));
+	std::println("user query: {} staff, {} ad*/navy, {} long names", staff.count(), ad_or_navy.count(),
+				 long_names.count());
+	expect(ad_or_navy.count() == 3 && long_names.count() == 2);
+	expect(materialize(columns, staff)[0].username == "adam");
+}
+
+//================================
+// 			STRING HASH
+//================================
+void test_string_hash() {
+	// every length class: empty, 1-3, 4-16, 17-48, >48
+	for (std::string_view key : { "", "a", "ada", "ada@example.com", "a-much-longer-username-than-usual",
+								  "0123456789012345678901234567890123456789012345678901234567890123" }) {
+		expect(string_hash::hash(key) == string_hash::hash(std::string(key)));
+		expect(key.empty() || string_hash::hash(key) != string_hash::hash(key.substr(1)));
+	}
+
+	// a group with a long key, an all-short group and a leftover key
+	std::string_view keys[] = { "ada", "", "grace@example.com", "alan", "barbara", "linus", "x", "ab", "turing" };
+	std::uint64_t batch[std::size(keys)];
+	string_hash::hash_batch(keys, batch);
+	for (std::size_t i = 0; i < std::size(keys); ++i) {
+		expect(batch[i] == string_hash::hash(keys[i]));
+	}
+
+	// User records hash by content through UserHash
+	const User ada { .username = "ada", .email = "ada@example.com" };
+	UserKeySet<> seen { ada };
+	UserKeyMap<User, int> logins { { ada, 3 } };
+	expect(seen.contains({ .username = "ada", .email = "ada@example.com" }) && logins.at(ada) == 3);
+
+	StringKeyMap<int> by_name { { "ada", 1 } };
+	std::println("string hash: ada -> {}", by_name.find(std::string_view("ada"))->second);
+}
+
+//================================
+// 			HASH JOIN
+//================================
+void test_hash_join() {
+	std::vector<User> source {
+		{ .username = "ada", .email = "ada@example.com" },
+		{ .username = "grace", .email = "grace@navy.mil" },
+		{ .username = "linus", .email = "linus@example.com" },
+	};
+	std::vector<User> directory {
+		{ .username = "grace", .email = "grace@navy.mil" },
+		{ .username = "ada", .email = "ada@corp.example" },
+		{ .username = "ada", .email = "ada@example.com" },
+	};
+
+	auto inner = hash_join(source, directory, JoinKey::username);
+	auto missing = hash_join(source, directory, JoinKey::username, JoinKind::anti);
+	auto stale = hash_join(directory, source, JoinKey::email, JoinKind::anti);
+	std::println("hash join: {} matches, {} missing, {} stale", inner.size(), missing.size(), stale.size());
+	expect(inner.size() == 3); // ada matches twice
+	expect(missing.size() == 1 && missing[0] == (JoinMatch { 2, JoinMatch::no_match }));
+	expect(stale.size() == 1 && stale[0].left == 1);
+	expect(hash_join(source, directory, JoinKey::email, JoinKind::left).size() == 3);
+}
+
+//================================
+// 			SNAPSHOT DIFF
+//================================
+void test_snapshot_diff() {
+	std::vector<User> before, after;
+	for (int i = 0; i < 1000; ++i) {
+		const std::string name = "user" + std::to_string(i);
+		before.push_back({ .username = name, .email = name + "@example.com" });
+	}
+	after = before;
+	after[10].email = "moved@corp.example";
+	after.erase(after.begin() + 500);
+	after.push_back({ .username = "newcomer", .email = "newcomer@example.com" });
+
+	auto diff = snapshot_diff(before, after);
+	std::println("snapshot diff: {} added, {} removed, {} changed, {} blocks opened", diff.added.size(),
+				 diff.removed.size(), diff.changed.size(), diff.blocks_compared);
+	expect(diff.added.size() == 1 && after[diff.added[0]].username == "newcomer");
+	expect(diff.removed.size() == 1 && diff.removed[0] == 500);
+	expect(diff.changed.size() == 1 && diff.changed[0] == (std::pair<std::size_t, std::size_t> { 10, 10 }));
+	expect(diff.blocks_compared <= 3);
+	expect(snapshot_diff(before, before).blocks_compared == 0);
+}
+
+//================================
+// 			SERIALIZE
+//================================
+void test_serialize() {
+	// trivially copyable: one memcpy each way, the view aliases the buffer
+	std::vector<Vec3> points = { { .e0 = 1, .e1 = 2, .e2 = 3 }, { .e0 = -4, .e1 = 5.5f, .e2 = 0 } };
+	auto point_bytes = serial::write(points);
+	std::span<const Vec3> point_view = serial::view<Vec3>(point_bytes);
+	expect(point_view.size() == 2 && point_view[1].e1 == 5.5f);
+	expect(static_cast<const void *>(point_view.data()) > static_cast<const void *>(point_bytes.data()));
+
+	// string fields: fixed rows plus a string heap, read back as views
+	std::vector<User> users = { { .username = "ada", .email = "ada@example.com" }, { .username = "", .email = "x@y" } };
+	auto user_bytes = serial::write(users);
+	auto reader = serial::view<User>(user_bytes);
+	std::string_view email = reader.get<1>(0);
+	std::println("serialize: {} points, {} users ({} bytes), first email {}", point_view.size(), reader.size(),
+				 user_bytes.size(), email);
+	expect(email == "ada@example.com" && reader.get<0>(1).empty());
+	expect(serial::read<User>(user_bytes) == users);
+}
+
+//================================
+// 			BENCH STATS
+//================================
+void test_bench_stats() {
+	BenchResult base { "kernel", 1000, {} }, same { "kernel", 1000, {} }, slower { "kernel", 1000, {} };
+	std::mt19937 rng(3);
+	std::lognormal_distribution<double> noise(0.0, 0.05);
+	for (int i = 0; i < 30; ++i) {
+		base.ns_per_op.push_back(100 * noise(rng));
+		same.ns_per_op.push_back(100 * noise(rng));
+		slower.ns_per_op.push_back(120 * noise(rng));
+	}
+
+	auto unchanged = bench_stats::compare(base, same);
+	auto regressed = bench_stats::compare(base, slower);
+	std::println("bench stats: ratio {} (p {}), ratio {} (p {})", unchanged.ratio, unchanged.p_value, regressed.ratio,
+				 regressed.p_value);
+	expect(unchanged.verdict == bench_stats::Verdict::same);
+	expect(regressed.verdict == bench_stats::Verdict::slower && regressed.ci.low > 1);
+
+	BenchRun run { BenchEnvironment::capture("demo \"label\""), { base, slower } };
+	BenchRun back = bench_run_from_json(to_json(run));
+	expect(back.environment.label == run.environment.label && back.environment.cores == run.environment.cores);
+	expect(back.results.size() == 2 && back.results[1].ns_per_op == slower.ns_per_op);
+
+	// \u escapes decode to UTF-8, surrogate pairs included; non-finite numbers are written as null
+	auto parse = [](std::string_view text) { return bench_json::Parser(text).parse(); };
+	expect(parse(R"("caf\u00e9 \ud83d\ude00\u0001")").str() == "caf\xc3\xa9 \xf0\x9f\x98\x80\x01");
+	for (std::string_view bad : { R"("\ud83d")", R"("\ude00")", R"("\u00g1")", R"("\u12")", "nan", "-inf" }) {
+		bool threw = false;
+		try {
+			parse(bad);
+		}
+		catch (const std::runtime_error &) {
+			threw = true;
+		}
+		expect(threw);
+	}
+	expect(bench_json::number(std::numeric_limits<double>::infinity()) == "null");
+	expect(std::isnan(parse("[null]").arr()[0].num()));
+
+	// runs are matched by name: one benchmark in both, one dropped, one new
+	BenchResult dropped { "old_kernel", 1000, { 50 } }, added { "new_kernel", 1000, { 70 } };
+	const auto verdicts = bench_stats::compare(BenchRun { {}, { base, dropped } }, BenchRun { {}, { same, added } });
+	expect(verdicts.size() == 3 && verdicts[0].verdict == bench_stats::Verdict::same);
+	expect(verdicts[1].name == "new_kernel" && verdicts[1].verdict == bench_stats::Verdict::added &&
+		   verdicts[1].current_median == 70);
+	expect(verdicts[2].name == "old_kernel" && verdicts[2].verdict == bench_stats::Verdict::missing);
+}
+
+//================================
+// 			DEVICE FARM
+//================================
+void test_device_farm() {
+	// debouncer: a two-poll glitch is ignored, three agreeing polls flip the level
+	Debouncer debouncer(1, 3);
+	std::uint8_t changed = 0;
+	for (std::uint8_t raw : { 1, 1, 0, 1, 1 }) {
+		debouncer.update(0, std::span(&raw, 1), std::span(&changed, 1));
+		expect(changed == 0);
+	}
+	std::uint8_t one = 1;
+	debouncer.update(0, std::span(&one, 1), std::span(&changed, 1));
+	expect(changed == 1 && debouncer.level(0) == 1);
+
+	// noiseless farm: every debounced event is real and typically arrives debounce_polls - 1 polls after the toggle
+	// (a rare double toggle between two polls can make one look earlier)
+	DeviceFarm farm({ .devices = 2000, .toggle_rate_hz = 20, .bounce_probability = 0, .noise_probability = 0,
+					  .latency = LatencyModel::fixed, .latency_mean_us = 10 });
+	auto report = run_farm_load(farm, { .threads = 2, .rounds = 500, .debounce_polls = 3 });
+	std::println("device farm: {} reads, {} events, p50 {} us, p99 {} us", report.reads, report.events,
+				 report.latency.quantile(0.5), report.latency.quantile(0.99));
+	expect(report.reads == 2000 * 500 && report.events > 0 && report.spurious_events == 0);
+	expect(report.latency.quantile(0.01) >= 2 * 1000 + 10);
+
+	// the same load through ButtonWithConcept sees the same events
+	DeviceFarm again({ .devices = 2000, .toggle_rate_hz = 20, .bounce_probability = 0, .noise_probability = 0,
+					   .latency = LatencyModel::fixed, .latency_mean_us = 10 });
+	auto via_button = run_farm_load(again, { .threads = 1, .rounds = 500, .path = PollPath::button });
+	expect(via_button.events == report.events);
+
+	const auto config = parse_device_farm_config("# bench farm\n devices = 42 \nlatency = exponential\nseed=7\n");
+	expect(config.devices == 42 && config.latency == LatencyModel::exponential && config.seed == 7);
+	expect(config.toggle_rate_hz == DeviceFarmConfig {}.toggle_rate_hz);
+	bool rejected = false;
+	try {
+		parse_device_farm_config("devices = 10\nlatency = gaussian\n");
+	}
+	catch (const std::invalid_argument &e) {
+		rejected = std::string(e.what()).find("line 2") != std::string::npos;
+	}
+	expect(rejected);
+}
+
+//================================
+// 			MEMORY FOOTPRINT
+//================================
+void test_memory_footprint() {
+	const auto parsed = ProcessMemory::parse_smaps_rollup("55d0c0000000-7ffc00000000 ---p 00000000 00:00 0   [rollup]\n"
+														  "Rss:                5120 kB\n"
+														  "Pss:                4096 kB\n"
+														  "Private_Dirty:      2048 kB\n"
+														  "Anonymous:          1024 kB\n"
+														  "THPeligible:           0\n");
+	expect(parsed.rss == 5120 * 1024 && parsed.pss == 4096 * 1024);
+	expect(parsed.private_dirty == 2048 * 1024 && parsed.anonymous == 1024 * 1024);
+
+	// the test executable has no heap hooks, so heap figures stay zero; the bench target installs them
+	const auto r = measure_footprint("vec3", 1'000'000, sizeof(Vec3), [](std::size_t n) {
+		return std::vector<Vec3>(n, Vec3 { 1, 2, 3 });
+	});
+	std::println("memory footprint: rss {} B/element, process rss {} bytes", r.rss_per_element(),
+				 ProcessMemory::capture().rss);
+	expect(!heap_stats::installed && r.heap_bytes == 0 && r.allocations == 0);
+	expect(r.elements == 1'000'000 && r.element_size == 12);
+#if defined(__linux__)
+	expect(ProcessMemory::capture().rss > 0);
+#endif
+}
+
+//================================
+// 			STARTUP PROFILE
+//================================
+void test_startup_profile() {
+	StartupProfile profile;
+	const int answer = profile.phase("config_load", [] { return 42; });
+	std::vector<MockedDigitalInput> inputs(8);
+	for (auto &input : inputs) {
+		input.set_value(1);
+	}
+	std::vector<std::uint8_t> levels(inputs.size());
+	profile_device_startup(profile, std::span(inputs), std::span(levels));
+
+	const StartupReport report = profile.report();
+	std::println("startup profile: {} phases, total {} ns", report.phases.size(), report.total.count());
+	expect(answer == 42 && std::ranges::all_of(levels, [](std::uint8_t l) { return l == 1; }));
+	expect(report.find("static_init") != nullptr && report.find("first_poll") != nullptr);
+	expect(report.process_start_known == (report.find("loader") != nullptr));
+	for (std::size_t i = 0; i < report.phases.size(); ++i) {
+		const auto &p = report.phases[i];
+		expect(p.start.count() >= 0 && p.duration.count() >= 0 && p.start + p.duration <= report.total);
+		expect(i == 0 || p.start >= report.phases[i - 1].start + report.phases[i - 1].duration);
+	}
+	expect(report.unattributed().count() >= 0);
+
+	const auto json = bench_json::Parser(to_json(report)).parse();
+	expect(json["phases"].arr().size() == report.phases.size());
+	expect(json["phases"].arr().back()["name"].str() == "first_poll");
+}
+
+//================================
+// 			THREAD POOL
+//================================
+void test_thread_pool() {
+	// under --threads the registry runs this test inside its own parallel_for, so that pool is current here
+	ThreadPool &outer = ThreadPool::current();
+	ThreadPool pool(3);
+	std::mutex mutex;
+	std::unordered_set<std::thread::id> threads;
+	std::atomic<std::size_t> covered { 0 }, saw_pool { 0 };
+	{
+		ThreadPool::Scope scope(pool);
+		expect(&ThreadPool::current() == &pool);
+		parallel_for(1000, 1, [&](std::size_t b, std::size_t e) {
+			// helpers run with the loop's pool installed, so nested kernels use it too
+			saw_pool += &ThreadPool::current() == &pool ? e - b : 0;
+			covered += e - b;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			std::lock_guard lock(mutex);
+			threads.insert(std::this_thread::get_id());
+		});
+	}
+	std::println("thread pool: {} threads ran the chunks", threads.size());
+	expect(covered == 1000 && saw_pool == 1000 && threads.size() <= pool.size());
+	expect(&ThreadPool::current() == &outer);
+
+	// Scopes on different threads are independent: overlapping lifetimes never leak an installation
+	ThreadPool other(2);
+	std::atomic<int> stage { 0 };
+	bool other_kept = false;
+	std::jthread t([&] {
+		ThreadPool::Scope scope(other);
+		stage = 1;
+		stage.notify_one();
+		stage.wait(1);
+		other_kept = &ThreadPool::current() == &other;
+	});
+	stage.wait(0);
+	{
+		ThreadPool::Scope scope(pool);
+		stage = 2;
+		stage.notify_one();
+		t.join();
+		expect(other_kept && &ThreadPool::current() == &pool);
+	}
+	expect(&ThreadPool::current() == &outer);
+}
+
+//================================
+// 			SFINAE FAST PATHS
+//================================
+void test_sfinae_fast_paths() {
+	static_assert(is_digital_input_buffer_type_trait_v<std::vector<MockedDigitalInput>>);
+	static_assert(!is_digital_input_buffer_type_trait_v<std::vector<MalformedDigitalInput>>);
+
+	// polling + debounce: the C++17 entry points and the span API agree poll for poll
+	std::vector<MockedDigitalInput> inputs(100);
+	std::vector<std::uint8_t> levels17(inputs.size()), levels20(inputs.size());
+	std::vector<std::uint8_t> changed17(inputs.size()), changed20(inputs.size());
+	Debouncer debouncer17(inputs.size()), debouncer20(inputs.size());
+	std::mt19937 rng(5);
+	for (int poll = 0; poll < 50; ++poll) {
+		for (auto &input : inputs) {
+			input.set_value(static_cast<int>(rng() % 4 != 0));
+		}
+		cxx17::poll_inputs(inputs, levels17);
+		poll_inputs(std::span(inputs), std::span(levels20));
+		cxx17::debounce(debouncer17, 0, levels17, changed17);
+		debouncer20.update(0, std::span<const std::uint8_t>(levels20), std::span(changed20));
+		expect(levels17 == levels20 && changed17 == changed20);
+	}
+
+	// kernels: bit-identical to the parallel C++20 versions
+	auto points = std::vector<Vec3>(5000);
+	for (auto &p : points) {
+		p = { static_cast<float>(rng() % 1000), static_cast<float>(rng() % 1000), static_cast<float>(rng() % 1000) };
+	}
+	const Affine3 a = Quat::from_axis_angle({ 1, 2, 3 }, 0.3f).to_affine({ 1, 0, -1 });
+	auto moved17 = points, moved20 = points;
+	cxx17::transform_points(a, moved17);
+	transform_points(a, std::span(moved20));
+	expect(std::memcmp(moved17.data(), moved20.data(), points.size() * sizeof(Vec3)) == 0);
+
+	const std::span<const Vec3> rows(points.data(), 300), cols(points.data() + 300, 700);
+	std::vector<float> d17(rows.size() * cols.size()), d20(d17.size());
+	cxx17::pairwise_sq_distances(rows, cols, d17);
+	pairwise_sq_distances(rows, cols, d20);
+	std::println("sfinae fast paths: {} polls, {} distances compared", 50, d17.size());
+	expect(d17 == d20);
+}
+
+//================================
+// 			SHARDED COUNTERS
+//================================
+void test_sharded_counters() {
+	// 8 shards: every writer owns one; 1 shard: most writers share the overflow shard
+	for (std::size_t shards : { std::size_t { 8 }, std::size_t { 1 } }) {
+		ShardedCounters<std::int64_t> counters(1000, shards);
+		std::atomic<bool> done { false };
+		bool monotonic = true;
+		std::jthread reader([&] {
+			// totals only grow, so every merged read must be at least the previous one
+			std::int64_t last = 0;
+			while (!done) {
+				const auto v = counters.values();
+				const std::int64_t total = std::accumulate(v.begin(), v.end(), std::int64_t { 0 });
+				monotonic = monotonic && total >= last;
+				last = total;
+			}
+		});
+		{
+			std::vector<std::jthread> writers;
+			for (int t = 0; t < 6; ++t) {
+				writers.emplace_back([&counters, t] {
+					for (int i = 0; i < 20000; ++i) {
+						counters.add(static_cast<std::size_t>(i * 7 + t) % 1000);
+					}
+				});
+			}
+		}
+		done = true;
+		reader.join();
+
+		const auto v = counters.values();
+		std::println("sharded counters ({} shards): counter 0 = {}", counters.shards(), v[0]);
+		expect(monotonic && std::ranges::all_of(v, [](std::int64_t c) { return c == 120; }));
+		expect(counters.value(999) == 120);
+		counters.reset();
+		expect(counters.value(0) == 0 && counters.values()[999] == 0);
+	}
+
+	ShardedCounters<std::int32_t> narrow(3, 2);
+	narrow.add(1, std::numeric_limits<std::int32_t>::max());
+	narrow.add(1, 1);
+	narrow.add(2, -4);
+	expect(narrow.values() == std::vector<std::int32_t> { 0, std::numeric_limits<std::int32_t>::min(), -4 });
+}
+
+//================================
+// 			SUMMATION
+//================================
+void test_summation() {
+	// 2M + 5 copies of 0.1f: a naive float sum drifts by percents, both accurate sums stay within a few ulps
+	std::vector<float> tenths((1 << 21) + 5, 0.1f);
+	const long double exact = static_cast<long double>(0.1f) * static_cast<long double>(tenths.size());
+	const auto rel = [exact](long double s) { return std::abs(s - exact) / exact; };
+	const float naive = std::accumulate(tenths.begin(), tenths.end(), 0.0f);
+	std::println("summation: naive {} pairwise {} neumaier {} exact {}", naive, pairwise_sum(tenths),
+				 neumaier_sum(tenths), static_cast<double>(exact));
+	expect(rel(pairwise_sum(tenths)) < 1e-6L && rel(neumaier_sum(tenths)) < 2e-7L && rel(naive) > 1e-3L);
+	const std::vector<double> wide(tenths.begin(), tenths.end());
+	expect(rel(pairwise_sum(wide)) < 1e-12L && rel(neumaier_sum(wide)) < 1e-12L);
+
+	// every lane sees 1e8, 1, -1e8: only compensation keeps the ones
+	std::vector<float> cancel(3 * 24 + 1, 0.5f);
+	std::fill_n(cancel.begin(), 24, 1e8f);
+	std::fill_n(cancel.begin() + 24, 24, 1.0f);
+	std::fill_n(cancel.begin() + 48, 24, -1e8f);
+	expect(neumaier_sum(cancel) == 24.5f);
+	expect(pairwise_sum(std::span<const float>()) == 0.0f && neumaier_sum(std::span<const double>()) == 0.0);
+
+	// a large scene far from the origin: float centroid against a double reference
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+	std::vector<Vec3> points(1'000'003);
+	double ref[3] = {};
+	for (auto &p : points) {
+		p = { 1000.0f + jitter(rng), -2000.0f + jitter(rng), 3000.0f + jitter(rng) };
+		ref[0] += p.e0;
+		ref[1] += p.e1;
+		ref[2] += p.e2;
+	}
+	const auto n = static_cast<double>(points.size());
+	const Vec3 c = centroid(points), s = neumaier_sum(points);
+	std::println("summation: centroid ({}, {}, {})", c.e0, c.e1, c.e2);
+	expect(std::abs(c.e0 - ref[0] / n) < 1e-3 && std::abs(c.e1 - ref[1] / n) < 1e-3 &&
+		   std::abs(c.e2 - ref[2] / n) < 1e-3);
+	expect(std::abs(s.e2 - ref[2]) / ref[2] < 1e-7);
+	expect(centroid(std::span<const Vec3>()).e0 == 0.0f);
+}
+
+//================================
+// 			SIMD SORT
+//================================
+template<std::integral T>
+bool simd_sort_matches_std_sort(std::size_t n, int shape, std::mt19937_64 &rng) {
+	std::vector<T> keys(n);
+	for (auto &k : keys) {
+		k = static_cast<T>(shape == 1 ? rng() % 5 : shape == 2 ? 42 : rng());
+	}
+	if (shape == 3) {
+		std::ranges::sort(keys, std::greater<>());
+	}
+	auto expected = keys;
+	std::ranges::sort(expected);
+	simd_sort(std::span(keys));
+	return keys == expected;
+}
+
+void test_simd_sort() {
+	// random, few distinct, all equal, descending; sizes around the network and vector widths
+	std::mt19937_64 rng(3);
+	bool ok = true;
+	for (std::size_t n : { 0, 1, 8, 9, 16, 17, 33, 1000, 100'003 }) {
+		for (int shape = 0; shape < 4; ++shape) {
+			ok = ok && simd_sort_matches_std_sort<std::int32_t>(n, shape, rng);
+			ok = ok && simd_sort_matches_std_sort<std::uint32_t>(n, shape, rng);
+			ok = ok && simd_sort_matches_std_sort<std::int64_t>(n, shape, rng);
+			ok = ok && simd_sort_matches_std_sort<std::uint64_t>(n, shape, rng);
+			ok = ok && simd_sort_matches_std_sort<std::int16_t>(n, shape, rng);
+		}
+	}
+	expect(ok);
+	std::vector<std::int32_t> extremes { std::numeric_limits<std::int32_t>::max(), 0, -1,
+										 std::numeric_limits<std::int32_t>::min(), 7 };
+	simd_sort(std::span(extremes));
+	expect(extremes == std::vector<std::int32_t> { std::numeric_limits<std::int32_t>::min(), -1, 0, 7,
+												   std::numeric_limits<std::int32_t>::max() });
+
+	// parallel runs + merge rounds
+	ThreadPool pool(3);
+	{
+		ThreadPool::Scope scope(pool);
+		std::vector<std::uint64_t> large(600'001);
+		for (auto &k : large) {
+			k = rng() % 1'000'000;
+		}
+		auto expected = large;
+		std::ranges::sort(expected);
+		simd_sort(std::span(large));
+		expect(large == expected);
+	}
+
+	// key/value: packed (32-bit key, 16-bit value) and radix (64-bit key, double value) paths
+	std::vector<std::int32_t> ids(50'000);
+	std::vector<std::uint16_t> rows(ids.size());
+	for (std::size_t i = 0; i < ids.size(); ++i) {
+		ids[i] = static_cast<std::int32_t>(rng() % 2000) - 1000;
+		rows[i] = static_cast<std::uint16_t>(i);
+	}
+	const auto original = ids;
+	simd_sort_pairs(std::span(ids), std::span(rows));
+	expect(std::ranges::is_sorted(ids));
+	expect(std::ranges::all_of(std::views::iota(std::size_t { 0 }, ids.size()),
+							   [&](std::size_t i) { return original[rows[i]] == ids[i]; }));
+
+	std::vector<std::int64_t> stamps(10'000);
+	std::vector<double> payload(stamps.size());
+	for (std::size_t i = 0; i < stamps.size(); ++i) {
+		stamps[i] = static_cast<std::int64_t>(rng());
+		payload[i] = static_cast<double>(stamps[i]);
+	}
+	simd_sort_pairs(std::span(stamps), std::span(payload));
+	expect(std::ranges::is_sorted(stamps));
+	expect(std::ranges::equal(stamps, payload, [](std::int64_t k, double v) { return static_cast<double>(k) == v; }));
+	std::println("simd sort: {} .. {}", stamps.front(), stamps.back());
+}
+
+//================================
+// 			SORTED SETS
+//================================
+void test_sorted_sets() {
+	// each size pair runs a different path: empty, merge/vector, galloping either way round
+	std::mt19937_64 rng(11);
+	auto random_set = [&rng](std::size_t n, std::uint32_t range) {
+		std::vector<std::uint32_t> v(n);
+		for (auto &x : v) {
+			x = static_cast<std::uint32_t>(rng() % range);
+		}
+		std::ranges::sort(v);
+		v.erase(std::unique(v.begin(), v.end()), v.end());
+		return v;
+	};
+	bool ok = true;
+	for (auto [na, nb] : { std::pair<std::size_t, std::size_t> { 0, 10 }, { 10, 0 }, { 3000, 3000 }, { 5000, 7 },
+						   { 40, 20'000 }, { 20'000, 19'000 } }) {
+		const auto a = random_set(na, 30'000), b = random_set(nb, 30'000);
+		std::vector<std::uint32_t> both, either, only_a;
+		std::ranges::set_intersection(a, b, std::back_inserter(both));
+		std::ranges::set_union(a, b, std::back_inserter(either));
+		std::ranges::set_difference(a, b, std::back_inserter(only_a));
+		ok = ok && sorted_intersection<std::uint32_t>(a, b) == both;
+		ok = ok && sorted_union<std::uint32_t>(a, b) == either && sorted_difference<std::uint32_t>(a, b) == only_a;
+
+		// an exactly sized output has no room for a full vector store past the end
+		std::vector<std::uint32_t> out(std::min(a.size(), b.size()));
+		out.resize(sorted_intersection<std::uint32_t>(a, b, out));
+		ok = ok && out == both;
+	}
+	expect(ok);
+	const std::vector<std::int64_t> a { -5, -1, 3, 9 }, b { -1, 9, 10 };
+	expect(sorted_intersection<std::int64_t>(a, b) == std::vector<std::int64_t> { -1, 9 });
+	expect(sorted_difference<std::int64_t>(b, a) == std::vector<std::int64_t> { 10 });
+
+	// combining two user filters through their row lists matches filtering on both at once
+	UserColumns table = UserColumns::from(std::vector<User> {
+		{ .username = "ada", .email = "ada@corp.example" },
+		{ .username = "adam", .email = "adam@example.com" },
+		{ .username = "adele", .email = "adele@corp.example" },
+		{ .username = "grace", .email = "grace@corp.example" },
+	});
+	using namespace user_query;
+	const auto ad = filter(table.view(), username.starts_with("ad")).rows();
+	const auto corp = filter(table.view(), email.domain_in({ "corp.example" })).rows();
+	const auto both = sorted_intersection<std::uint32_t>(ad, corp);
+	std::println("sorted sets: ad* {} corp {} both {}", ad.size(), corp.size(), both.size());
+	expect(both == filter(table.view(), username.starts_with("ad") && email.domain_in({ "corp.example" })).rows());
+	expect(sorted_union<std::uint32_t>(ad, corp).size() == 4);
+	expect(sorted_difference<std::uint32_t>(ad, corp) == std::vector<std::uint32_t> { 1 });
+}
+
+//================================
+// 			ROARING BITMAP
+//================================
+void test_roaring_bitmap() {
+	// chunk 0 sparse (array), chunk 2 dense (bitmap), chunk 5 one long range (runs), plus scattered high values
+	std::mt19937_64 rng(13);
+	auto random_values = [&rng](std::size_t sparse, std::size_t dense) {
+		std::vector<std::uint32_t> v;
+		for (std::size_t i = 0; i < sparse; ++i) {
+			v.push_back(static_cast<std::uint32_t>(rng() % 65536));
+		}
+		for (std::size_t i = 0; i < dense; ++i) {
+			v.push_back(2 * 65536 + static_cast<std::uint32_t>(rng() % 65536));
+		}
+		const auto start = 5 * 65536 + static_cast<std::uint32_t>(rng() % 1000);
+		for (std::uint32_t x = start; x < start + 30'000; ++x) {
+			v.push_back(x);
+		}
+		for (int i = 0; i < 20; ++i) {
+			v.push_back(static_cast<std::uint32_t>(rng()));
+		}
+		std::ranges::sort(v);
+		v.erase(std::unique(v.begin(), v.end()), v.end());
+		return v;
+	};
+	const auto a = random_values(3000, 40'000), b = random_values(20'000, 1000);
+	const auto ra = RoaringBitmap::from_sorted(a), rb = RoaringBitmap::from_sorted(b);
+	RoaringBitmap built;
+	for (const auto x : b) {
+		built.set(x);
+	}
+	expect(ra.rows() == a && ra.count() == a.size() && built.rows() == b);
+	expect(ra.test(a[1234]) && ra.test(a[1234] + 1) == std::ranges::binary_search(a, a[1234] + 1));
+
+	// array x bitmap x run pairings against the sorted-list kernels
+	expect((ra & rb).rows() == sorted_intersection<std::uint32_t>(a, b));
+	expect((ra | rb).rows() == sorted_union<std::uint32_t>(a, b));
+	expect((ra - rb).rows() == sorted_difference<std::uint32_t>(a, b));
+	expect((rb - ra).rows() == sorted_difference<std::uint32_t>(b, a) && (built & ra).rows() == (rb & ra).rows());
+
+	// runs: the 30000-value range costs a few bytes once optimized, against 8 KiB as a bitmap
+	const std::size_t before = built.bytes();
+	built.optimize();
+	std::println("roaring bitmap: {} values, {} -> {} bytes after optimize", built.count(), before, built.bytes());
+	expect(built.bytes() < before && built.rows() == b);
+
+	// as a user filter result
+	UserColumns table = UserColumns::from(std::vector<User> {
+		{ .username = "ada", .email = "ada@corp.example" },
+		{ .username = "linus", .email = "linus@example.com" },
+		{ .username = "adele", .email = "adele@corp.example" },
+	});
+	using namespace user_query;
+	const auto selection = filter(table.view(), email.domain_in({ "corp.example" }));
+	const auto compressed = RoaringBitmap::from_words(selection.words());
+	expect(compressed.rows() == selection.rows());
+	expect(materialize(table.view(), compressed)[1].username == "adele");
+
+	// as the set of pressed buttons
+	std::vector<std::uint8_t> levels(100'000);
+	for (std::size_t i = 0; i < levels.size(); i += 97) {
+		levels[i] = 1;
+	}
+	const auto pressed = RoaringBitmap::from_flags(levels);
+	expect(pressed.count() == static_cast<std::size_t>(std::ranges::count(levels, 1)) && pressed.test(97 * 1000) &&
+		   !pressed.test(1));
+}
+
 //================================
 // 			MAIN
 //================================
-int main()
+int main(int argc, char **argv)
 {
-	std::println("-------- FOO CHECK --------");
-	foo1(1);
-	foo2(2.5f);
-	foo3(3.7f);
-	
-	std::println("-------- ADD CHECK --------");
-	std::println("{}", add3(1, 2));
-	
-	std::println("-------- MOCKING 1 --------");
-	test_button_concept();
-	test_button_sfinae();
-	test_malformed_button();
-	
-	std::println("-------- MOCKING 2 --------");
-	test_digital_sensor();
-
-	return 0;
-}
\ No newline at end of file
+	TestRegistry tests;
+	tests.add("foo_check", [] {
+		foo1(1);
+		foo2(2.5f);
+		foo3(3.7f);
+	});
+	tests.add("add_check", [] {
+		std::println("{}", add3(1, 2));
+		expect(add3(1, 2) == 3);
+	});
+	tests.add("button_concept", test_button_concept);
+	tests.add("button_sfinae", test_button_sfinae);
+	tests.add("malformed_button", test_malformed_button);
+	tests.add("digital_sensor", test_digital_sensor);
+	tests.add("point_cloud_io", test_point_cloud_io);
+	tests.add("vec3_pipeline", test_vec3_pipeline);
+	tests.add("morton_order", test_morton_order);
+	tests.add("kd_tree", test_kd_tree);
+	tests.add("voxel_grid", test_voxel_grid);
+	tests.add("pairwise_distance", test_pairwise_distance);
+	tests.add("quaternion", test_quaternion);
+	tests.add("arrow_columns", test_arrow_columns);
+	tests.add("user_query", test_user_query);
+	tests.add("string_hash", test_string_hash);
+	tests.add("hash_join", test_hash_join);
+	tests.add("snapshot_diff", test_snapshot_diff);
+	tests.add("serialize", test_serialize);
+	tests.add("bench_stats", test_bench_stats);
+	tests.add("device_farm", test_device_farm);
+	tests.add("memory_footprint", test_memory_footprint);
+	tests.add("startup_profile", test_startup_profile);
+	tests.add("thread_pool", test_thread_pool);
+	tests.add("sfinae_fast_paths", test_sfinae_fast_paths);
+	tests.add("sharded_counters", test_sharded_counters);
+	tests.add("summation", test_summation);
+	tests.add("simd_sort", test_simd_sort);
+	tests.add("sorted_sets", test_sorted_sets);
+	tests.add("roaring_bitmap", test_roaring_bitmap);
+
+	return tests.main(argc, argv);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//================================
+// 			MAPPED FILE
+//================================
+// Read-only, move-only mapping of a whole file. The bytes stay valid as long as the MappedFile lives.
+class MappedFile {
+public:
+	MappedFile() = default;
+
+	explicit MappedFile(const std::filesystem::path &path) {
+#if defined(_WIN32)
+		file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file_ == INVALID_HANDLE_VALUE) {
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+		}
+		LARGE_INTEGER size{};
+		GetFileSizeEx(file_, &size);
+		size_ = static_cast<std::size_t>(size.QuadPart);
+		if (size_ != 0) {
+			mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping_ == nullptr) {
+				auto err = static_cast<int>(GetLastError());
+				release();
+				throw std::system_error(err, std::system_category(), path.string());
+			}
+			data_ = static_cast<const std::byte *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+		}
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::system_error(errno, std::generic_category(), path.string());
+		}
+		struct stat st{};
+		if (::fstat(fd, &st) != 0) {
+			auto err = errno;
+			::close(fd);
+			throw std::system_error(err, std::generic_category(), path.string());
+		}
+		size_ = static_cast<std::size_t>(st.st_size);
+		if (size_ != 0) {
+			void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED) {
+				auto err = errno;
+				::close(fd);
+				throw std::system_error(err, std::generic_category(), path.string());
+			}
+			data_ = static_cast<const std::byte *>(p);
+		}
+		::close(fd); // the mapping keeps its own reference to the file
+#endif
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&other) noexcept {
+		swap(other);
+	}
+
+	MappedFile &operator=(MappedFile &&other) noexcept {
+		if (this != &other) {
+			release();
+			swap(other);
+		}
+		return *this;
+	}
+
+	~MappedFile() {
+		release();
+	}
+
+	std::span<const std::byte> bytes() const {
+		return { data_, size_ };
+	}
+
+	std::size_t size() const {
+		return size_;
+	}
+
+	// Tell the kernel we walk the file front to back: larger readahead, pages dropped behind us.
+	void advise_sequential() const {
+#if !defined(_WIN32)
+		if (data_ != nullptr) {
+			::madvise(const_cast<std::byte *>(data_), size_, MADV_SEQUENTIAL);
+		}
+#endif
+	}
+
+	// Kick off readahead for a byte range we are about to touch.
+	void advise_willneed(std::size_t offset, std::size_t length) const {
+#if !defined(_WIN32)
+		if (data_ == nullptr || offset >= size_) {
+			return;
+		}
+		auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		auto begin = offset / page * page; // madvise wants a page-aligned address
+		auto end = std::min(size_, offset + length);
+		::madvise(const_cast<std::byte *>(data_) + begin, end - begin, MADV_WILLNEED);
+#else
+		(void)offset;
+		(void)length;
+#endif
+	}
+
+private:
+	void swap(MappedFile &other) noexcept {
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+#if defined(_WIN32)
+		std::swap(file_, other.file_);
+		std::swap(mapping_, other.mapping_);
+#endif
+	}
+
+	void release() noexcept {
+#if defined(_WIN32)
+		if (data_ != nullptr) {
+			UnmapViewOfFile(data_);
+		}
+		if (mapping_ != nullptr) {
+			CloseHandle(mapping_);
+		}
+		if (file_ != INVALID_HANDLE_VALUE) {
+			CloseHandle(file_);
+		}
+		file_ = INVALID_HANDLE_VALUE;
+		mapping_ = nullptr;
+#else
+		if (data_ != nullptr) {
+			::munmap(const_cast<std::byte *>(data_), size_);
+		}
+#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+
+	const std::byte *data_{};
+	std::size_t size_{};
+#if defined(_WIN32)
+	HANDLE file_{ INVALID_HANDLE_VALUE };
+	HANDLE mapping_{};
+#endif
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+//================================
+// 			HEAP STATS
+//================================
+// Live / peak heap bytes and allocation counts, fed by replacement operator new / delete. The hooks themselves
+// live in the executable that wants them (see bench.cpp), which sets `installed`; without them everything
+// here reads zero.
+namespace heap_stats {
+
+inline std::atomic<bool> installed{ false };
+inline std::atomic<std::int64_t> live_bytes{ 0 };
+inline std::atomic<std::int64_t> peak_bytes{ 0 };
+inline std::atomic<std::uint64_t> allocations{ 0 };
+
+inline void on_alloc(std::size_t bytes) {
+	const auto live = live_bytes.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed) +
+					  static_cast<std::int64_t>(bytes);
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	for (auto peak = peak_bytes.load(std::memory_order_relaxed);
+		 live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed);) {
+	}
+}
+
+inline void on_free(std::size_t bytes) {
+	live_bytes.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+}
+
+// Restarts peak tracking from the current live size.
+inline void reset_peak() {
+	peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+} // namespace heap_stats
+
+//================================
+// 			PROCESS MEMORY
+//================================
+// What the kernel charges the process, from /proc/self/smaps_rollup (Linux 4.14+), falling back to
+// /proc/self/statm for RSS alone. Elsewhere every field is zero.
+struct ProcessMemory {
+	std::uint64_t rss{};		   // resident bytes
+	std::uint64_t pss{};		   // resident bytes with shared pages split between their users
+	std::uint64_t anonymous{};	   // resident heap/stack/anonymous mappings
+	std::uint64_t private_dirty{}; // pages only this process has written
+
+	// Parses the "Name:   123 kB" lines of smaps_rollup; unknown lines are ignored.
+	static ProcessMemory parse_smaps_rollup(std::string_view text) {
+		ProcessMemory m;
+		while (!text.empty()) {
+			const std::size_t eol = std::min(text.find('\n'), text.size());
+			const std::string_view line = text.substr(0, eol);
+			text.remove_prefix(std::min(eol + 1, text.size()));
+
+			const std::size_t colon = line.find(':');
+			if (colon == std::string_view::npos) {
+				continue;
+			}
+			const std::string_view key = line.substr(0, colon);
+			std::string_view value = line.substr(colon + 1);
+			value.remove_prefix(std::min(value.find_first_not_of(' '), value.size()));
+			std::uint64_t kb{};
+			if (std::from_chars(value.data(), value.data() + value.size(), kb).ec != std::errc{}) {
+				continue;
+			}
+			const std::uint64_t bytes = kb * 1024;
+			if (key == "Rss") {
+				m.rss = bytes;
+			}
+			else if (key == "Pss") {
+				m.pss = bytes;
+			}
+			else if (key == "Anonymous") {
+				m.anonymous = bytes;
+			}
+			else if (key == "Private_Dirty") {
+				m.private_dirty = bytes;
+			}
+		}
+		return m;
+	}
+
+	static ProcessMemory capture() {
+		if (std::ifstream rollup("/proc/self/smaps_rollup"); rollup) {
+			std::stringstream text;
+			text << rollup.rdbuf();
+			return parse_smaps_rollup(text.str());
+		}
+		ProcessMemory m;
+#if defined(__unix__) || defined(__APPLE__)
+		if (std::ifstream statm("/proc/self/statm"); statm) {
+			std::uint64_t size{}, resident{};
+			statm >> size >> resident;
+			m.rss = resident * static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+		}
+#endif
+		return m;
+	}
+};
+
+//================================
+// 			MEMORY FOOTPRINT
+//================================
+// Cost of keeping `elements` objects alive: build() returns the population, which is held while the heap counters
+// and process memory are read, then released. Deltas are taken against the state just before build(), after
+// returning free pages to the OS, so RSS reflects the population and not leftovers of an earlier one.
+struct FootprintResult {
+	std::string name;
+	std::size_t elements{};
+	std::size_t element_size{}; // inline bytes per element (sizeof, summed over columns for SoA layouts)
+	std::int64_t heap_bytes{};	// live heap held by the population
+	std::int64_t peak_heap_bytes{}; // highest heap growth while building it
+	std::uint64_t allocations{};
+	std::int64_t rss_bytes{};
+	std::int64_t anonymous_bytes{};
+
+	double heap_per_element() const {
+		return per_element(heap_bytes);
+	}
+
+	double peak_heap_per_element() const {
+		return per_element(peak_heap_bytes);
+	}
+
+	double rss_per_element() const {
+		return per_element(rss_bytes);
+	}
+
+private:
+	double per_element(std::int64_t bytes) const {
+		return elements == 0 ? 0 : static_cast<double>(bytes) / static_cast<double>(elements);
+	}
+};
+
+namespace memory_detail {
+
+inline void release_free_pages() {
+#if defined(__GLIBC__)
+	::malloc_trim(0);
+#endif
+}
+
+} // namespace memory_detail
+
+template<std::invocable<std::size_t> Build>
+FootprintResult measure_footprint(std::string name, std::size_t elements, std::size_t element_size, Build &&build) {
+	memory_detail::release_free_pages();
+	const ProcessMemory before = ProcessMemory::capture();
+	const std::int64_t heap_before = heap_stats::live_bytes.load();
+	const std::uint64_t allocations_before = heap_stats::allocations.load();
+	heap_stats::reset_peak();
+
+	const auto population = build(elements);
+
+	const ProcessMemory after = ProcessMemory::capture();
+	FootprintResult r;
+	r.name = std::move(name);
+	r.elements = elements;
+	r.element_size = element_size;
+	r.heap_bytes = heap_stats::live_bytes.load() - heap_before;
+	r.peak_heap_bytes = heap_stats::peak_bytes.load() - heap_before;
+	r.allocations = heap_stats::allocations.load() - allocations_before;
+	r.rss_bytes = static_cast<std::int64_t>(after.rss) - static_cast<std::int64_t>(before.rss);
+	r.anonymous_bytes = static_cast<std::int64_t>(after.anonymous) - static_cast<std::int64_t>(before.anonymous);
+	return r;
+}
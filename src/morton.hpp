@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "vec3.hpp"
+
+//================================
+// 			MORTON CODES
+//================================
+// 63-bit Z-order codes: each axis is quantized to 21 bits inside a bounding box and the bits are interleaved
+// as ...z1y1x1z0y0x0. Points close in space end up close in code order, which is what makes the reordering
+// below cache friendly for neighbor queries and rendering.
+namespace morton {
+
+inline constexpr int bits_per_axis = 21;
+inline constexpr int code_bits = 3 * bits_per_axis;
+inline constexpr std::uint32_t axis_max = (1u << bits_per_axis) - 1;
+
+// Spreads the low 21 bits of v so that two zero bits follow each of them.
+inline std::uint64_t spread_bits(std::uint32_t v) {
+#if defined(__BMI2__)
+	return _pdep_u64(v, 0x1249249249249249ull);
+#else
+	std::uint64_t x = v & axis_max;
+	x = (x | x << 32) & 0x001f00000000ffffull;
+	x = (x | x << 16) & 0x001f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+#endif
+}
+
+inline std::uint32_t compact_bits(std::uint64_t x) {
+#if defined(__BMI2__)
+	return static_cast<std::uint32_t>(_pext_u64(x, 0x1249249249249249ull));
+#else
+	x &= 0x1249249249249249ull;
+	x = (x | x >> 2) & 0x10c30c30c30c30c3ull;
+	x = (x | x >> 4) & 0x100f00f00f00f00full;
+	x = (x | x >> 8) & 0x001f0000ff0000ffull;
+	x = (x | x >> 16) & 0x001f00000000ffffull;
+	x = (x | x >> 32) & axis_max;
+	return static_cast<std::uint32_t>(x);
+#endif
+}
+
+inline std::uint64_t encode(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+	return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+}
+
+struct Cell {
+	std::uint32_t x, y, z;
+};
+
+inline Cell decode(std::uint64_t code) {
+	return { compact_bits(code), compact_bits(code >> 1), compact_bits(code >> 2) };
+}
+
+// Maps points of a bounding box onto the 2^21 grid used by encode().
+class Quantizer {
+public:
+	explicit Quantizer(const Aabb &box) : lo_(box.lo) {
+		auto scale = [](float lo, float hi) {
+			float extent = hi - lo;
+			return extent > 0 ? static_cast<float>(axis_max) / extent : 0.0f;
+		};
+		scale_[0] = scale(box.lo.e0, box.hi.e0);
+		scale_[1] = scale(box.lo.e1, box.hi.e1);
+		scale_[2] = scale(box.lo.e2, box.hi.e2);
+	}
+
+	std::uint64_t operator()(const Vec3 p) const {
+		return encode(quantize(p.e0, lo_.e0, scale_[0]), quantize(p.e1, lo_.e1, scale_[1]),
+					  quantize(p.e2, lo_.e2, scale_[2]));
+	}
+
+private:
+	static std::uint32_t quantize(float v, float lo, float scale) {
+		float q = std::clamp((v - lo) * scale, 0.0f, static_cast<float>(axis_max));
+		return static_cast<std::uint32_t>(q);
+	}
+
+	Vec3 lo_;
+	float scale_[3];
+};
+
+} // namespace morton
+
+// Parallel bounding box of a point span.
+inline Aabb compute_bounds(std::span<const Vec3> points) {
+	Aabb box;
+	std::mutex merge;
+	parallel_for(points.size(), 64 * 1024, [&](std::size_t b, std::size_t e) {
+		Aabb local;
+		for (std::size_t i = b; i < e; ++i) {
+			local.extend(points[i]);
+		}
+		std::lock_guard lock(merge);
+		box.extend(local);
+	});
+	return box;
+}
+
+// Fills `codes` with the Morton code of every point, quantized inside `box`.
+inline void compute_morton_codes(std::span<const Vec3> points, const Aabb &box, std::span<std::uint64_t> codes) {
+	assert(codes.size() == points.size());
+	morton::Quantizer quantize(box);
+	parallel_for(points.size(), 16 * 1024, [&](std::size_t b, std::size_t e) {
+		for (std::size_t i = b; i < e; ++i) {
+			codes[i] = quantize(points[i]);
+		}
+	});
+}
+
+// Permutation that visits `points` in Z-order: points[order[0]], points[order[1]], ...
+inline std::vector<std::uint32_t> morton_order(std::span<const Vec3> points) {
+	assert(points.size() <= UINT32_MAX);
+	std::vector<std::uint64_t> codes(points.size());
+	compute_morton_codes(points, compute_bounds(points), codes);
+
+	std::vector<std::uint32_t> order(points.size());
+	std::iota(order.begin(), order.end(), 0u);
+	radix_sort_pairs(std::span(codes), std::span(order), morton::code_bits);
+	return order;
+}
+
+// Sorts `points` into Z-order in place.
+inline void morton_reorder(std::span<Vec3> points) {
+	auto order = morton_order(points);
+	std::vector<Vec3> sorted(points.size());
+	parallel_for(points.size(), 64 * 1024, [&](std::size_t b, std::size_t e) {
+		for (std::size_t i = b; i < e; ++i) {
+			sorted[i] = points[order[i]];
+		}
+	});
+	std::copy(sorted.begin(), sorted.end(), points.begin());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "parallel.hpp"
+#include "vec3.hpp"
+#include "vec3_kernels.hpp"
+
+//================================
+// 			PAIRWISE DISTANCE
+//================================
+// Tiling and kernels are in vec3_kernels.hpp (shared with the C++17 entry points); these add the thread pool.
+
+// Full distance matrix: out[i * b.size() + j] = |a[i] - b[j]|^2.
+inline void pairwise_sq_distances(std::span<const Vec3> a, std::span<const Vec3> b, std::span<float> out) {
+	using namespace distance_detail;
+	assert(out.size() == a.size() * b.size());
+	parallel_for(task_count(a.size(), b.size()), 1, [&](std::size_t tb, std::size_t te) {
+		SoATile tile;
+		for (std::size_t task = tb; task < te; ++task) {
+			distance_task(a.data(), a.size(), b.data(), b.size(), task, tile, out.data());
+		}
+	});
+}
+
+struct ClosePair {
+	std::uint32_t i; // index into a
+	std::uint32_t j; // index into b
+	float dist2;
+};
+
+// Only the pairs with |a_i - b_j|^2 <= max_dist2; the full matrix is never materialized.
+// Pairs come out grouped by tile, not sorted.
+inline std::vector<ClosePair> close_pairs(std::span<const Vec3> a, std::span<const Vec3> b, float max_dist2) {
+	using namespace distance_detail;
+	std::vector<ClosePair> result;
+	std::mutex merge;
+	parallel_for(task_count(a.size(), b.size()), 1, [&](std::size_t tb, std::size_t te) {
+		SoATile tile;
+		std::vector<float> scratch(tile_rows * tile_cols);
+		std::vector<ClosePair> local;
+		auto scan = [&](std::size_t r, std::size_t rows, std::size_t col) {
+			tile_kernel(a.data() + r, rows, tile, scratch.data(), tile_cols);
+			for (std::size_t k = 0; k < rows; ++k) {
+				const float *row = scratch.data() + k * tile_cols;
+				for (std::size_t j = 0; j < tile.count; ++j) {
+					if (row[j] <= max_dist2) {
+						local.push_back(
+							{ static_cast<std::uint32_t>(r + k), static_cast<std::uint32_t>(col + j), row[j] });
+					}
+				}
+			}
+		};
+		for (std::size_t task = tb; task < te; ++task) {
+			for_each_task_step(a.size(), b.data(), b.size(), task, tile, scan);
+		}
+		std::lock_guard lock(merge);
+		result.insert(result.end(), local.begin(), local.end());
+	});
+	return result;
+}
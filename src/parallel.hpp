@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//================================
+// 			THREAD POOL
+//================================
+// Fixed set of workers pulling fire-and-forget jobs from one queue. Most code should go through
+// parallel_for() below rather than submitting jobs directly.
+class ThreadPool {
+public:
+	explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+		workers_.reserve(threads);
+		for (std::size_t i = 0; i < threads; ++i) {
+			workers_.emplace_back([this](std::stop_token stop) { run(stop); });
+		}
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	~ThreadPool() {
+		for (auto &w : workers_) {
+			w.request_stop();
+		}
+		cv_.notify_all();
+	}
+
+	std::size_t size() const {
+		return workers_.size();
+	}
+
+	void submit(std::function<void()> job) {
+		{
+			std::lock_guard lock(mutex_);
+			jobs_.push_back(std::move(job));
+		}
+		cv_.notify_one();
+	}
+
+	// Process-wide pool sized to the machine.
+	static ThreadPool &shared() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	// Pool that parallel_for() and the kernels built on it use when none is passed: shared(), unless a Scope on
+	// this thread has installed another. parallel_for() installs its pool around every chunk it runs, so kernels
+	// nested inside the chunks, on the caller or on helpers, see the pool of the enclosing loop.
+	static ThreadPool &current() {
+		return current_ != nullptr ? *current_ : shared();
+	}
+
+	// Makes `pool` current() on this thread for the Scope's lifetime, e.g. to run existing kernels at a given
+	// thread count. Scopes nest like any RAII guard; other threads are unaffected.
+	class Scope {
+	public:
+		explicit Scope(ThreadPool &pool) : previous_(std::exchange(current_, &pool)) {}
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+		~Scope() {
+			current_ = previous_;
+		}
+
+	private:
+		ThreadPool *previous_;
+	};
+
+private:
+	static inline thread_local ThreadPool *current_ = nullptr;
+
+	void run(std::stop_token stop) {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock lock(mutex_);
+				cv_.wait(lock, stop, [this] { return !jobs_.empty(); });
+				if (jobs_.empty()) {
+					return; // stop requested and nothing left to do
+				}
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+			}
+			job();
+		}
+	}
+
+	std::mutex mutex_;
+	std::condition_variable_any cv_;
+	std::deque<std::function<void()>> jobs_;
+	std::vector<std::jthread> workers_; // last member: joined before the queue is destroyed
+};
+
+//================================
+// 			PARALLEL FOR
+//================================
+// Splits [0, n) into chunks of at least `grain` items and runs fn(begin, end) on them across the pool.
+// The calling thread works on chunks too and only waits for chunks, never for helper jobs, so a
+// parallel_for nested inside a pool job cannot deadlock. The first exception thrown by fn is rethrown here.
+// A pool of size N runs at most N chunks at once: the caller plus N - 1 helpers.
+template<typename F>
+void parallel_for(std::size_t n, std::size_t grain, F &&fn, ThreadPool &pool = ThreadPool::current()) {
+	if (n == 0) {
+		return;
+	}
+	grain = std::max<std::size_t>(grain, 1);
+	std::size_t chunks = std::min((n + grain - 1) / grain, pool.size() * 4);
+	if (chunks <= 1 || pool.size() <= 1) {
+		ThreadPool::Scope scope(pool);
+		fn(std::size_t{ 0 }, n);
+		return;
+	}
+
+	struct State {
+		std::atomic<std::size_t> next{ 0 };
+		std::atomic<std::size_t> done{ 0 };
+		std::exception_ptr error;
+		std::mutex error_mutex;
+	};
+	auto state = std::make_shared<State>();
+	std::size_t chunk = (n + chunks - 1) / chunks;
+	chunks = (n + chunk - 1) / chunk;
+
+	// helpers may start after we return; they only touch fn after claiming a chunk, which keeps us waiting
+	auto work = [state, chunks, chunk, n, &fn, pool = &pool] {
+		ThreadPool::Scope scope(*pool);
+		for (std::size_t c; (c = state->next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+			try {
+				fn(c * chunk, std::min(n, (c + 1) * chunk));
+			}
+			catch (...) {
+				std::lock_guard lock(state->error_mutex);
+				if (!state->error) {
+					state->error = std::current_exception();
+				}
+			}
+			if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+				state->done.notify_all();
+			}
+		}
+	};
+
+	std::size_t helpers = std::min(chunks - 1, pool.size() - 1);
+	for (std::size_t i = 0; i < helpers; ++i) {
+		pool.submit(work);
+	}
+	work();
+
+	for (std::size_t d; (d = state->done.load(std::memory_order_acquire)) != chunks;) {
+		state->done.wait(d, std::memory_order_acquire);
+	}
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
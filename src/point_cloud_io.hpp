@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.hpp"
+#include "vec3.hpp"
+
+//================================
+// 			STRIDED VIEW
+//================================
+// Vec3 view over interleaved records (e.g. PLY vertices carrying normals/colors next to x/y/z).
+// Elements are assembled with memcpy, so the underlying bytes need no particular alignment.
+class StridedVec3View {
+public:
+	StridedVec3View() = default;
+
+	StridedVec3View(const std::byte *base, std::size_t count, std::size_t stride, std::size_t off_x,
+					std::size_t off_y, std::size_t off_z)
+		: base_(base), count_(count), stride_(stride), off_{ off_x, off_y, off_z } {}
+
+	Vec3 operator[](std::size_t i) const {
+		const std::byte *rec = base_ + i * stride_;
+		Vec3 v;
+		std::memcpy(&v.e0, rec + off_[0], sizeof(float));
+		std::memcpy(&v.e1, rec + off_[1], sizeof(float));
+		std::memcpy(&v.e2, rec + off_[2], sizeof(float));
+		return v;
+	}
+
+	std::size_t size() const {
+		return count_;
+	}
+
+	std::size_t stride() const {
+		return stride_;
+	}
+
+	bool empty() const {
+		return count_ == 0;
+	}
+
+	class iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Vec3;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		iterator(const StridedVec3View *view, std::size_t i) : view_(view), i_(i) {}
+
+		Vec3 operator*() const {
+			return (*view_)[i_];
+		}
+		Vec3 operator[](difference_type n) const {
+			return (*view_)[i_ + n];
+		}
+		iterator &operator++() {
+			++i_;
+			return *this;
+		}
+		iterator operator++(int) {
+			auto tmp = *this;
+			++i_;
+			return tmp;
+		}
+		iterator &operator--() {
+			--i_;
+			return *this;
+		}
+		iterator operator--(int) {
+			auto tmp = *this;
+			--i_;
+			return tmp;
+		}
+		iterator &operator+=(difference_type n) {
+			i_ += n;
+			return *this;
+		}
+		iterator &operator-=(difference_type n) {
+			i_ -= n;
+			return *this;
+		}
+		friend iterator operator+(iterator it, difference_type n) {
+			return it += n;
+		}
+		friend iterator operator+(difference_type n, iterator it) {
+			return it += n;
+		}
+		friend iterator operator-(iterator it, difference_type n) {
+			return it -= n;
+		}
+		friend difference_type operator-(const iterator &a, const iterator &b) {
+			return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_);
+		}
+		friend bool operator==(const iterator &a, const iterator &b) {
+			return a.i_ == b.i_;
+		}
+		friend auto operator<=>(const iterator &a, const iterator &b) {
+			return a.i_ <=> b.i_;
+		}
+
+	private:
+		const StridedVec3View *view_{};
+		std::size_t i_{};
+	};
+
+	iterator begin() const {
+		return { this, 0 };
+	}
+	iterator end() const {
+		return { this, count_ };
+	}
+
+private:
+	const std::byte *base_{};
+	std::size_t count_{};
+	std::size_t stride_{};
+	std::size_t off_[3]{};
+};
+
+static_assert(std::random_access_iterator<StridedVec3View::iterator>);
+
+//================================
+// 			POINT CLOUD READER
+//================================
+// Opens binary little-endian PLY files or headerless binary XYZ files (packed float triples) without copying them.
+// When vertices are exactly three packed floats and the payload happens to be float-aligned, points() is a plain
+// span over the mapping; otherwise strided() gives the same data through an interleaved view.
+class PointCloudReader {
+public:
+	enum class Format { Ply, Xyz };
+
+	static PointCloudReader open(const std::filesystem::path &path) {
+		PointCloudReader reader;
+		reader.file_ = MappedFile(path);
+		reader.file_.advise_sequential();
+
+		auto bytes = reader.file_.bytes();
+		std::string_view text(reinterpret_cast<const char *>(bytes.data()), std::min<std::size_t>(bytes.size(), 3));
+		if (text == "ply") {
+			reader.parse_ply();
+		}
+		else {
+			reader.parse_xyz();
+		}
+		return reader;
+	}
+
+	Format format() const {
+		return format_;
+	}
+
+	std::size_t size() const {
+		return view_.size();
+	}
+
+	// True when points() can hand out the mapped vertices directly.
+	bool contiguous() const {
+		return contiguous_;
+	}
+
+	// Zero-copy span over the mapped vertices. Only valid when contiguous().
+	std::span<const Vec3> points() const {
+		if (!contiguous_) {
+			throw std::logic_error("point cloud layout is interleaved; use strided()");
+		}
+		return { reinterpret_cast<const Vec3 *>(payload_), view_.size() };
+	}
+
+	// Always available, whatever the vertex layout.
+	const StridedVec3View &strided() const {
+		return view_;
+	}
+
+	const MappedFile &file() const {
+		return file_;
+	}
+
+private:
+	PointCloudReader() = default;
+
+	static std::size_t ply_type_size(std::string_view type) {
+		if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") {
+			return 1;
+		}
+		if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") {
+			return 2;
+		}
+		if (type == "int" || type == "uint" || type == "float" || type == "int32" || type == "uint32" ||
+			type == "float32") {
+			return 4;
+		}
+		if (type == "double" || type == "float64") {
+			return 8;
+		}
+		throw std::runtime_error("unsupported PLY property type: " + std::string(type));
+	}
+
+	void parse_ply() {
+		static_assert(std::endian::native == std::endian::little, "PLY payload is read in place");
+
+		auto bytes = file_.bytes();
+		std::string_view text(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+		auto header_end = text.find("end_header\n");
+		if (header_end == std::string_view::npos) {
+			throw std::runtime_error("PLY header is not terminated");
+		}
+		std::size_t data_offset = header_end + std::string_view("end_header\n").size();
+		std::string_view header = text.substr(0, header_end);
+
+		bool in_vertex = false;
+		bool seen_vertex = false;
+		std::size_t count = 0;
+		std::size_t stride = 0;
+		std::optional<std::size_t> off[3];
+
+		while (!header.empty()) {
+			auto eol = header.find('\n');
+			auto line = header.substr(0, eol);
+			header = eol == std::string_view::npos ? std::string_view{} : header.substr(eol + 1);
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+
+			auto next_word = [&line]() {
+				auto start = line.find_first_not_of(' ');
+				if (start == std::string_view::npos) {
+					line = {};
+					return std::string_view{};
+				}
+				line.remove_prefix(start);
+				auto end = line.find(' ');
+				auto word = line.substr(0, end);
+				line = end == std::string_view::npos ? std::string_view{} : line.substr(end);
+				return word;
+			};
+
+			auto keyword = next_word();
+			if (keyword == "format") {
+				if (next_word() != "binary_little_endian") {
+					throw std::runtime_error("only binary_little_endian PLY files can be mapped");
+				}
+			}
+			else if (keyword == "element") {
+				auto name = next_word();
+				auto n = std::stoull(std::string(next_word()));
+				if (seen_vertex) {
+					in_vertex = false; // elements after the vertex block do not affect its offset
+					continue;
+				}
+				in_vertex = name == "vertex";
+				if (in_vertex) {
+					seen_vertex = true;
+					count = n;
+				}
+				else if (n != 0) {
+					// fixed-size elements before the vertices would shift the payload; lists would need a scan
+					throw std::runtime_error("PLY elements before 'vertex' are not supported");
+				}
+			}
+			else if (keyword == "property" && in_vertex) {
+				auto type = next_word();
+				if (type == "list") {
+					throw std::runtime_error("list properties on vertices are not supported");
+				}
+				auto name = next_word();
+				auto size = ply_type_size(type);
+				int axis = name == "x" ? 0 : name == "y" ? 1 : name == "z" ? 2 : -1;
+				if (axis >= 0) {
+					if (size != sizeof(float) || (type != "float" && type != "float32")) {
+						throw std::runtime_error("PLY x/y/z must be float properties");
+					}
+					off[axis] = stride;
+				}
+				stride += size;
+			}
+		}
+
+		if (!seen_vertex || !off[0] || !off[1] || !off[2]) {
+			throw std::runtime_error("PLY file has no float x/y/z vertex properties");
+		}
+		// count comes from the header, so count * stride could wrap: divide instead
+		if (stride == 0 || data_offset > bytes.size() || count > (bytes.size() - data_offset) / stride) {
+			throw std::runtime_error("PLY vertex data is truncated");
+		}
+
+		format_ = Format::Ply;
+		payload_ = bytes.data() + data_offset;
+		view_ = StridedVec3View(payload_, count, stride, *off[0], *off[1], *off[2]);
+		contiguous_ = stride == sizeof(Vec3) && *off[0] == 0 && *off[1] == 4 && *off[2] == 8 &&
+					  reinterpret_cast<std::uintptr_t>(payload_) % alignof(Vec3) == 0;
+	}
+
+	void parse_xyz() {
+		auto bytes = file_.bytes();
+		if (bytes.size() % sizeof(Vec3) != 0) {
+			throw std::runtime_error("binary XYZ size is not a multiple of 3 floats");
+		}
+		format_ = Format::Xyz;
+		payload_ = bytes.data();
+		view_ = StridedVec3View(payload_, bytes.size() / sizeof(Vec3), sizeof(Vec3), 0, 4, 8);
+		contiguous_ = true; // mmap hands out page-aligned memory
+	}
+
+	MappedFile file_;
+	Format format_{ Format::Xyz };
+	const std::byte *payload_{};
+	StridedVec3View view_;
+	bool contiguous_{};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "parallel.hpp"
+
+//================================
+// 			RADIX SORT
+//================================
+// Stable LSD radix sort of unsigned keys with a payload riding along (typically an index, giving a permutation).
+// Each pass builds per-chunk digit histograms in parallel, prefix-sums them, then scatters chunks in parallel.
+// Only the low `key_bits` bits are looked at, and passes whose digit is the same for every key are skipped.
+template<std::unsigned_integral Key, typename Value>
+void radix_sort_pairs(std::span<Key> keys, std::span<Value> values, int key_bits = std::numeric_limits<Key>::digits) {
+	assert(keys.size() == values.size());
+	constexpr int digit_bits = 11;
+	constexpr std::size_t buckets = std::size_t{ 1 } << digit_bits;
+	constexpr std::size_t grain = 64 * 1024;
+
+	const std::size_t n = keys.size();
+	if (n < 2) {
+		return;
+	}
+
+	std::vector<Key> key_tmp(n);
+	std::vector<Value> value_tmp(n);
+	std::span<Key> key_src = keys, key_dst = key_tmp;
+	std::span<Value> value_src = values, value_dst = value_tmp;
+
+	const std::size_t chunks = std::clamp<std::size_t>(n / grain, 1, ThreadPool::current().size());
+	const std::size_t chunk = (n + chunks - 1) / chunks;
+	std::vector<std::array<std::size_t, buckets>> hist(chunks);
+
+	for (int shift = 0; shift < key_bits; shift += digit_bits) {
+		auto digit = [shift](Key k) { return static_cast<std::size_t>(k >> shift) & (buckets - 1); };
+
+		parallel_for(chunks, 1, [&](std::size_t cb, std::size_t ce) {
+			for (std::size_t c = cb; c < ce; ++c) {
+				auto &h = hist[c];
+				h.fill(0);
+				for (std::size_t i = c * chunk, end = std::min(n, (c + 1) * chunk); i < end; ++i) {
+					++h[digit(key_src[i])];
+				}
+			}
+		});
+
+		// exclusive prefix, digit-major then chunk-major, keeps equal digits in input order
+		std::size_t sum = 0;
+		bool single_bucket = false;
+		for (std::size_t d = 0; d < buckets; ++d) {
+			std::size_t digit_total = 0;
+			for (std::size_t c = 0; c < chunks; ++c) {
+				std::size_t count = hist[c][d];
+				hist[c][d] = sum;
+				sum += count;
+				digit_total += count;
+			}
+			single_bucket |= digit_total == n;
+		}
+		if (single_bucket) {
+			continue; // every key has the same digit here, the pass would be a plain copy
+		}
+
+		parallel_for(chunks, 1, [&](std::size_t cb, std::size_t ce) {
+			for (std::size_t c = cb; c < ce; ++c) {
+				auto &offset = hist[c];
+				for (std::size_t i = c * chunk, end = std::min(n, (c + 1) * chunk); i < end; ++i) {
+					std::size_t dst = offset[digit(key_src[i])]++;
+					key_dst[dst] = key_src[i];
+					value_dst[dst] = value_src[i];
+				}
+			}
+		});
+		std::swap(key_src, key_dst);
+		std::swap(value_src, value_dst);
+	}
+
+	if (key_src.data() != keys.data()) {
+		std::copy(key_src.begin(), key_src.end(), keys.begin());
+		std::copy(value_src.begin(), value_src.end(), values.begin());
+	}
+}
@@ -0,0 +1,463 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "sorted_set.hpp"
+
+//================================
+// 			ROARING CONTAINERS
+//================================
+// A container holds the low 16 bits of the values sharing one high half, in whichever of three forms is
+// smallest: a sorted array (2 bytes per value, up to array_max values), a 65536-bit bitmap (8 KiB), or runs of
+// consecutive values ((start, length - 1) pairs, 4 bytes per run). Set operations and updates keep arrays and
+// bitmaps on their side of array_max; runs only come from the bulk builders and shrink(), and an operation or
+// update that meets one first expands it into an array or a bitmap.
+namespace roaring_detail {
+
+inline constexpr std::size_t array_max = 4096;
+inline constexpr std::size_t bitmap_words = 1024;
+
+enum class Kind : std::uint8_t { array, bitmap, run };
+
+enum class Op : std::uint8_t { and_, or_, and_not };
+
+struct Container {
+	Kind kind = Kind::array;
+	std::uint32_t cardinality = 0;
+	std::vector<std::uint16_t> values; // array: sorted values; run: (start, length - 1) pairs
+	std::vector<std::uint64_t> words;  // bitmap: bitmap_words words, LSB first
+
+	bool test(std::uint16_t v) const {
+		switch (kind) {
+		case Kind::array:
+			return std::binary_search(values.begin(), values.end(), v);
+		case Kind::bitmap:
+			return (words[v / 64] >> (v % 64) & 1) != 0;
+		case Kind::run: {
+			// last run starting at or before v
+			std::size_t lo = 0, hi = values.size() / 2;
+			while (lo < hi) {
+				const std::size_t mid = lo + (hi - lo) / 2;
+				if (values[2 * mid] <= v) {
+					lo = mid + 1;
+				}
+				else {
+					hi = mid;
+				}
+			}
+			return lo > 0 && v - values[2 * (lo - 1)] <= values[2 * (lo - 1) + 1];
+		}
+		}
+		return false;
+	}
+
+	// Calls fn(low 16 bits) for every value, in order.
+	template<typename F>
+	void for_each(F &&fn) const {
+		switch (kind) {
+		case Kind::array:
+			for (const std::uint16_t v : values) {
+				fn(v);
+			}
+			break;
+		case Kind::bitmap:
+			for (std::size_t w = 0; w < bitmap_words; ++w) {
+				for (auto bits = words[w]; bits != 0; bits &= bits - 1) {
+					fn(static_cast<std::uint16_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(bits))));
+				}
+			}
+			break;
+		case Kind::run:
+			for (std::size_t r = 0; r < values.size(); r += 2) {
+				for (std::uint32_t v = values[r], end = v + values[r + 1]; v <= end; ++v) {
+					fn(static_cast<std::uint16_t>(v));
+				}
+			}
+			break;
+		}
+	}
+
+	std::size_t bytes() const {
+		return values.capacity() * sizeof(std::uint16_t) + words.capacity() * sizeof(std::uint64_t);
+	}
+};
+
+inline Container make_array(std::vector<std::uint16_t> values) {
+	Container c;
+	c.cardinality = static_cast<std::uint32_t>(values.size());
+	c.values = std::move(values);
+	return c;
+}
+
+inline Container make_bitmap(std::vector<std::uint64_t> words) {
+	assert(words.size() == bitmap_words);
+	Container c;
+	c.kind = Kind::bitmap;
+	for (const auto w : words) {
+		c.cardinality += static_cast<std::uint32_t>(std::popcount(w));
+	}
+	c.words = std::move(words);
+	return c;
+}
+
+// Array at or below array_max values, bitmap above.
+inline Container normalized(Container c) {
+	if (c.kind == Kind::array && c.cardinality > array_max) {
+		std::vector<std::uint64_t> words(bitmap_words);
+		for (const std::uint16_t v : c.values) {
+			words[v / 64] |= std::uint64_t{ 1 } << (v % 64);
+		}
+		return make_bitmap(std::move(words));
+	}
+	if (c.kind == Kind::bitmap && c.cardinality <= array_max) {
+		std::vector<std::uint16_t> values;
+		values.reserve(c.cardinality);
+		c.for_each([&](std::uint16_t v) { values.push_back(v); });
+		return make_array(std::move(values));
+	}
+	if (c.kind == Kind::run) {
+		std::vector<std::uint16_t> values;
+		values.reserve(c.cardinality);
+		c.for_each([&](std::uint16_t v) { values.push_back(v); });
+		return normalized(make_array(std::move(values)));
+	}
+	return c;
+}
+
+inline std::size_t run_count(const Container &c) {
+	std::size_t runs = 0;
+	switch (c.kind) {
+	case Kind::array:
+		for (std::size_t i = 0; i < c.values.size(); ++i) {
+			runs += i == 0 || c.values[i] != c.values[i - 1] + 1;
+		}
+		break;
+	case Kind::bitmap: {
+		// a run starts at every set bit whose lower neighbour (carried across words) is clear
+		std::uint64_t carry = 0;
+		for (const auto w : c.words) {
+			runs += static_cast<std::size_t>(std::popcount(w & ~(w << 1 | carry)));
+			carry = w >> 63;
+		}
+		break;
+	}
+	case Kind::run:
+		runs = c.values.size() / 2;
+		break;
+	}
+	return runs;
+}
+
+// The smallest of the three forms.
+inline Container shrink(Container c) {
+	const std::size_t runs = run_count(c);
+	const std::size_t flat = std::min<std::size_t>(2 * c.cardinality, 2 * bitmap_words * sizeof(std::uint64_t));
+	if (4 * runs >= flat) {
+		return normalized(std::move(c));
+	}
+	if (c.kind == Kind::run) {
+		return c;
+	}
+	std::vector<std::uint16_t> pairs;
+	pairs.reserve(2 * runs);
+	c.for_each([&](std::uint16_t v) {
+		if (!pairs.empty() && pairs[pairs.size() - 2] + pairs.back() + 1 == v) {
+			++pairs.back();
+		}
+		else {
+			pairs.push_back(v);
+			pairs.push_back(0);
+		}
+	});
+	Container r;
+	r.kind = Kind::run;
+	r.cardinality = c.cardinality;
+	r.values = std::move(pairs);
+	return r;
+}
+
+// out = a op b word by word; returns the number of bits set in out.
+template<Op op>
+std::uint32_t combine_words(const std::uint64_t *a, const std::uint64_t *b, std::uint64_t *out) {
+	std::size_t i = 0;
+#if defined(__AVX2__)
+	for (; i < bitmap_words; i += 4) {
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+		const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+		__m256i r;
+		if constexpr (op == Op::and_) {
+			r = _mm256_and_si256(x, y);
+		}
+		else if constexpr (op == Op::or_) {
+			r = _mm256_or_si256(x, y);
+		}
+		else {
+			r = _mm256_andnot_si256(y, x);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+	}
+#endif
+	for (; i < bitmap_words; ++i) {
+		out[i] = op == Op::and_ ? a[i] & b[i] : op == Op::or_ ? a[i] | b[i] : a[i] & ~b[i];
+	}
+	std::uint32_t cardinality = 0;
+	for (i = 0; i < bitmap_words; ++i) {
+		cardinality += static_cast<std::uint32_t>(std::popcount(out[i]));
+	}
+	return cardinality;
+}
+
+template<Op op>
+Container combine(const Container &lhs, const Container &rhs) {
+	if (lhs.kind == Kind::run || rhs.kind == Kind::run) {
+		return combine<op>(lhs.kind == Kind::run ? normalized(lhs) : lhs,
+						   rhs.kind == Kind::run ? normalized(rhs) : rhs);
+	}
+	const std::span<const std::uint16_t> a = lhs.values, b = rhs.values;
+	if (lhs.kind == Kind::array && rhs.kind == Kind::array) {
+		std::vector<std::uint16_t> out;
+		if constexpr (op == Op::and_) {
+			out = sorted_intersection(a, b);
+		}
+		else if constexpr (op == Op::or_) {
+			out = sorted_union(a, b);
+		}
+		else {
+			out = sorted_difference(a, b);
+		}
+		return normalized(make_array(std::move(out)));
+	}
+	if (lhs.kind == Kind::bitmap && rhs.kind == Kind::bitmap) {
+		Container c;
+		c.kind = Kind::bitmap;
+		c.words.resize(bitmap_words);
+		c.cardinality = combine_words<op>(lhs.words.data(), rhs.words.data(), c.words.data());
+		return normalized(std::move(c));
+	}
+	// one array, one bitmap
+	const Container &array = lhs.kind == Kind::array ? lhs : rhs, &bitmap = lhs.kind == Kind::array ? rhs : lhs;
+	if (op == Op::and_ || (op == Op::and_not && lhs.kind == Kind::array)) {
+		std::vector<std::uint16_t> out;
+		out.reserve(array.values.size());
+		for (const std::uint16_t v : array.values) {
+			if (bitmap.test(v) == (op == Op::and_)) {
+				out.push_back(v);
+			}
+		}
+		return make_array(std::move(out));
+	}
+	Container c = bitmap; // or_, or bitmap and_not array
+	for (const std::uint16_t v : array.values) {
+		const std::uint64_t bit = std::uint64_t{ 1 } << (v % 64);
+		const bool had = (c.words[v / 64] & bit) != 0;
+		if (op == Op::or_) {
+			c.words[v / 64] |= bit;
+			c.cardinality += !had;
+		}
+		else {
+			c.words[v / 64] &= ~bit;
+			c.cardinality -= had;
+		}
+	}
+	return normalized(std::move(c));
+}
+
+} // namespace roaring_detail
+
+//================================
+// 			ROARING BITMAP
+//================================
+// Compressed set of 32-bit values (row ids, device indices), one container per 65536-value chunk that holds
+// anything. It reads like SelectionBitmap (test, set, count, for_each, rows), so it can stand in for one as a
+// filter result, but sparse and clustered sets cost memory in proportion to their content instead of their range.
+class RoaringBitmap {
+public:
+	RoaringBitmap() = default;
+
+	// From strictly increasing values.
+	static RoaringBitmap from_sorted(std::span<const std::uint32_t> values) {
+		RoaringBitmap out;
+		for (std::size_t i = 0; i < values.size();) {
+			const std::uint32_t key = values[i] >> 16;
+			std::vector<std::uint16_t> low;
+			for (; i < values.size() && values[i] >> 16 == key; ++i) {
+				assert(low.empty() || static_cast<std::uint16_t>(values[i]) > low.back());
+				low.push_back(static_cast<std::uint16_t>(values[i]));
+			}
+			out.keys_.push_back(static_cast<std::uint16_t>(key));
+			out.containers_.push_back(roaring_detail::shrink(roaring_detail::make_array(std::move(low))));
+		}
+		return out;
+	}
+
+	// From a dense bitmap, value i present when bit i % 64 of words[i / 64] is set (SelectionBitmap::words()).
+	static RoaringBitmap from_words(std::span<const std::uint64_t> words) {
+		using namespace roaring_detail;
+		RoaringBitmap out;
+		for (std::size_t first = 0; first < words.size(); first += bitmap_words) {
+			const std::size_t n = std::min(bitmap_words, words.size() - first);
+			std::vector<std::uint64_t> chunk(bitmap_words);
+			std::copy_n(words.begin() + first, n, chunk.begin());
+			Container c = make_bitmap(std::move(chunk));
+			if (c.cardinality != 0) {
+				out.keys_.push_back(static_cast<std::uint16_t>(first / bitmap_words));
+				out.containers_.push_back(shrink(std::move(c)));
+			}
+		}
+		return out;
+	}
+
+	// Value i present where flags[i] != 0, e.g. the levels from poll_inputs() as the set of pressed buttons.
+	static RoaringBitmap from_flags(std::span<const std::uint8_t> flags) {
+		std::vector<std::uint64_t> words((flags.size() + 63) / 64);
+		for (std::size_t i = 0; i < flags.size(); ++i) {
+			words[i / 64] |= static_cast<std::uint64_t>(flags[i] != 0) << (i % 64);
+		}
+		return from_words(words);
+	}
+
+	bool test(std::uint32_t value) const {
+		const auto it = std::lower_bound(keys_.begin(), keys_.end(), static_cast<std::uint16_t>(value >> 16));
+		return it != keys_.end() && *it == value >> 16 &&
+			   containers_[static_cast<std::size_t>(it - keys_.begin())].test(static_cast<std::uint16_t>(value));
+	}
+
+	void set(std::uint32_t value) {
+		using namespace roaring_detail;
+		const auto key = static_cast<std::uint16_t>(value >> 16);
+		const auto low = static_cast<std::uint16_t>(value);
+		const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+		const auto i = static_cast<std::size_t>(it - keys_.begin());
+		if (it == keys_.end() || *it != key) {
+			keys_.insert(it, key);
+			containers_.insert(containers_.begin() + static_cast<std::ptrdiff_t>(i), make_array({ low }));
+			return;
+		}
+		Container &c = containers_[i];
+		if (c.test(low)) {
+			return;
+		}
+		if (c.kind == Kind::run) {
+			c = normalized(std::move(c));
+		}
+		if (c.kind == Kind::array) {
+			c.values.insert(std::upper_bound(c.values.begin(), c.values.end(), low), low);
+			++c.cardinality;
+			c = normalized(std::move(c));
+		}
+		else {
+			c.words[low / 64] |= std::uint64_t{ 1 } << (low % 64);
+			++c.cardinality;
+		}
+	}
+
+	std::size_t count() const {
+		std::size_t n = 0;
+		for (const auto &c : containers_) {
+			n += c.cardinality;
+		}
+		return n;
+	}
+
+	bool empty() const {
+		return containers_.empty();
+	}
+
+	// Calls fn(value) for every value, in order.
+	template<typename F>
+	void for_each(F &&fn) const {
+		for (std::size_t i = 0; i < keys_.size(); ++i) {
+			const std::uint32_t high = std::uint32_t{ keys_[i] } << 16;
+			containers_[i].for_each([&](std::uint16_t low) { fn(high | low); });
+		}
+	}
+
+	// Values as a sorted id list.
+	std::vector<std::uint32_t> rows() const {
+		std::vector<std::uint32_t> out;
+		out.reserve(count());
+		for_each([&](std::uint32_t v) { out.push_back(v); });
+		return out;
+	}
+
+	// Re-picks the smallest form for every container, turning clustered values into runs.
+	void optimize() {
+		for (auto &c : containers_) {
+			c = roaring_detail::shrink(std::move(c));
+		}
+	}
+
+	// Heap bytes held, container payloads included.
+	std::size_t bytes() const {
+		std::size_t n = keys_.capacity() * sizeof(std::uint16_t);
+		n += containers_.capacity() * sizeof(roaring_detail::Container);
+		for (const auto &c : containers_) {
+			n += c.bytes();
+		}
+		return n;
+	}
+
+	friend RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b) {
+		return combine<roaring_detail::Op::and_>(a, b);
+	}
+
+	friend RoaringBitmap operator|(const RoaringBitmap &a, const RoaringBitmap &b) {
+		return combine<roaring_detail::Op::or_>(a, b);
+	}
+
+	// Values of a that are not in b.
+	friend RoaringBitmap operator-(const RoaringBitmap &a, const RoaringBitmap &b) {
+		return combine<roaring_detail::Op::and_not>(a, b);
+	}
+
+private:
+	// Walks both key lists in order; chunks present on one side only are copied when op keeps them.
+	template<roaring_detail::Op op>
+	static RoaringBitmap combine(const RoaringBitmap &a, const RoaringBitmap &b) {
+		using roaring_detail::Op;
+		RoaringBitmap out;
+		auto emit = [&out](std::uint16_t key, roaring_detail::Container c) {
+			if (c.cardinality != 0) {
+				out.keys_.push_back(key);
+				out.containers_.push_back(std::move(c));
+			}
+		};
+		std::size_t i = 0, j = 0;
+		while (i < a.keys_.size() || j < b.keys_.size()) {
+			const bool in_a = i < a.keys_.size() && (j == b.keys_.size() || a.keys_[i] <= b.keys_[j]);
+			const bool in_b = j < b.keys_.size() && (i == a.keys_.size() || b.keys_[j] <= a.keys_[i]);
+			if (in_a && in_b) {
+				emit(a.keys_[i], roaring_detail::combine<op>(a.containers_[i], b.containers_[j]));
+				++i;
+				++j;
+			}
+			else if (in_a) {
+				if (op != Op::and_) {
+					emit(a.keys_[i], a.containers_[i]);
+				}
+				++i;
+			}
+			else {
+				if (op == Op::or_) {
+					emit(b.keys_[j], b.containers_[j]);
+				}
+				++j;
+			}
+		}
+		return out;
+	}
+
+	std::vector<std::uint16_t> keys_; // high 16 bits, ascending
+	std::vector<roaring_detail::Container> containers_;
+};
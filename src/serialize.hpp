@@ -0,0 +1,379 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//================================
+// 			SERIALIZE
+//================================
+// Binary encoding of spans of plain aggregates, picked by concept:
+//  - trivially copyable records (Vec3, ...) are one memcpy, and serial::view<T> hands back a span<const T> that
+//    points straight into the buffer;
+//  - aggregates whose fields are trivially copyable or std::string (User, ...) become fixed-size rows, with each
+//    string stored as (offset, length) into a trailing heap. serial::view<T> returns a RecordReader whose get<I>()
+//    yields string_views into the buffer, so nothing is copied until a record is asked for as a T.
+// Fields are found by aggregate decomposition (at most 8, no nested aggregates or base classes). The encoding is
+// native-endian; it is meant for caches, IPC and replicas on the same architecture.
+namespace serial {
+
+namespace detail {
+
+struct AnyField {
+	template<typename F>
+	operator F() const;
+};
+
+template<typename T, std::size_t... I>
+constexpr bool brace_constructible(std::index_sequence<I...>) {
+	return requires { T{ (void(I), AnyField{})... }; };
+}
+
+template<typename T, std::size_t N = 8>
+constexpr std::size_t field_count() {
+	if constexpr (N == 0) {
+		return 0;
+	}
+	else if constexpr (brace_constructible<T>(std::make_index_sequence<N>{})) {
+		return N;
+	}
+	else {
+		return field_count<T, N - 1>();
+	}
+}
+
+// References to the fields of an aggregate, in declaration order.
+template<typename T>
+constexpr auto tie_fields(T &t) {
+	constexpr std::size_t n = field_count<std::remove_const_t<T>>();
+	if constexpr (n == 1) {
+		auto &[a] = t;
+		return std::tie(a);
+	}
+	else if constexpr (n == 2) {
+		auto &[a, b] = t;
+		return std::tie(a, b);
+	}
+	else if constexpr (n == 3) {
+		auto &[a, b, c] = t;
+		return std::tie(a, b, c);
+	}
+	else if constexpr (n == 4) {
+		auto &[a, b, c, d] = t;
+		return std::tie(a, b, c, d);
+	}
+	else if constexpr (n == 5) {
+		auto &[a, b, c, d, e] = t;
+		return std::tie(a, b, c, d, e);
+	}
+	else if constexpr (n == 6) {
+		auto &[a, b, c, d, e, f] = t;
+		return std::tie(a, b, c, d, e, f);
+	}
+	else if constexpr (n == 7) {
+		auto &[a, b, c, d, e, f, g] = t;
+		return std::tie(a, b, c, d, e, f, g);
+	}
+	else {
+		auto &[a, b, c, d, e, f, g, h] = t;
+		return std::tie(a, b, c, d, e, f, g, h);
+	}
+}
+
+template<typename T>
+using fields_t = decltype(tie_fields(std::declval<T &>()));
+
+template<typename T, std::size_t I>
+using field_t = std::remove_reference_t<std::tuple_element_t<I, fields_t<T>>>;
+
+} // namespace detail
+
+template<typename T>
+concept TrivialRecordConcept = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>;
+
+template<typename F>
+concept FieldConcept = std::is_trivially_copyable_v<F> || std::same_as<F, std::string>;
+
+template<typename T>
+concept StringRecordConcept = !TrivialRecordConcept<T> && std::is_aggregate_v<T> && std::default_initializable<T> &&
+							  detail::field_count<T>() > 0 && []<std::size_t... I>(std::index_sequence<I...>) {
+								  return (FieldConcept<detail::field_t<T, I>> && ...);
+							  }(std::make_index_sequence<detail::field_count<T>()>{});
+
+template<typename T>
+concept SerializableConcept = TrivialRecordConcept<T> || StringRecordConcept<T>;
+
+enum class Kind : std::uint32_t { trivial = 1, strings = 2 };
+
+struct Header {
+	std::array<char, 4> magic;
+	Kind kind;
+	std::uint64_t count;
+	std::uint32_t row_size;
+	std::uint32_t field_count;
+	std::uint64_t rows_offset;	 // from the start of the buffer
+	std::uint64_t strings_offset; // string heap, kind == strings only
+	std::uint64_t strings_size;
+};
+
+inline constexpr std::array<char, 4> magic = { 'S', 'E', 'R', '1' };
+inline constexpr std::size_t rows_alignment = 64;
+
+// A string field inside a row.
+struct StringRef {
+	std::uint32_t offset;
+	std::uint32_t length;
+};
+
+namespace detail {
+
+template<typename F>
+constexpr std::size_t slot_size() {
+	return std::same_as<F, std::string> ? sizeof(StringRef) : sizeof(F);
+}
+
+// Byte offset of each field inside a row: fields packed in order, no padding (slots are read with memcpy).
+template<typename T>
+constexpr auto slot_offsets() {
+	return []<std::size_t... I>(std::index_sequence<I...>) {
+		std::array<std::size_t, sizeof...(I) + 1> offsets{};
+		std::size_t at = 0;
+		((offsets[I] = at, at += slot_size<field_t<T, I>>()), ...);
+		offsets[sizeof...(I)] = at;
+		return offsets;
+	}(std::make_index_sequence<field_count<T>()>{});
+}
+
+template<typename T>
+inline constexpr auto slots = slot_offsets<T>();
+
+template<typename T>
+constexpr std::uint32_t row_size() {
+	if constexpr (TrivialRecordConcept<T>) {
+		return sizeof(T);
+	}
+	else {
+		return static_cast<std::uint32_t>(slots<T>.back());
+	}
+}
+
+constexpr std::size_t align_up(std::size_t n, std::size_t a) {
+	return (n + a - 1) / a * a;
+}
+
+[[noreturn]] inline void malformed(const char *what) {
+	throw std::runtime_error(std::string("malformed serialized buffer: ") + what);
+}
+
+template<typename T>
+Header check_header(std::span<const std::byte> bytes, Kind kind) {
+	if (bytes.size() < sizeof(Header)) {
+		malformed("shorter than its header");
+	}
+	Header h;
+	std::memcpy(&h, bytes.data(), sizeof(h));
+	if (h.magic != magic || h.kind != kind) {
+		malformed("wrong magic or record kind");
+	}
+	if (h.row_size != row_size<T>() || (kind == Kind::strings && h.field_count != field_count<T>())) {
+		throw std::runtime_error("serialized records do not have the layout of the requested type");
+	}
+	if (h.rows_offset > bytes.size() ||
+		h.count > (bytes.size() - h.rows_offset) / std::max<std::size_t>(h.row_size, 1)) {
+		malformed("rows run past the end");
+	}
+	if (kind == Kind::strings &&
+		(h.strings_offset > bytes.size() || h.strings_size > bytes.size() - h.strings_offset)) {
+		malformed("string heap runs past the end");
+	}
+	return h;
+}
+
+} // namespace detail
+
+// Encodes `records` into one buffer.
+template<SerializableConcept T>
+std::vector<std::byte> write(std::span<const T> records) {
+	Header h{ .magic = magic,
+			  .kind = TrivialRecordConcept<T> ? Kind::trivial : Kind::strings,
+			  .count = records.size(),
+			  .row_size = detail::row_size<T>(),
+			  .field_count = 0,
+			  .rows_offset = detail::align_up(sizeof(Header), std::max(rows_alignment, alignof(T))),
+			  .strings_offset = 0,
+			  .strings_size = 0 };
+	const std::size_t rows_bytes = records.size() * h.row_size;
+	std::vector<std::byte> out;
+
+	if constexpr (TrivialRecordConcept<T>) {
+		out.resize(h.rows_offset + rows_bytes);
+		if (rows_bytes != 0) {
+			std::memcpy(out.data() + h.rows_offset, records.data(), rows_bytes);
+		}
+	}
+	else {
+		h.field_count = static_cast<std::uint32_t>(detail::field_count<T>());
+		h.strings_offset = h.rows_offset + rows_bytes;
+		for (const T &record : records) {
+			std::apply([&](const auto &...field) {
+				((h.strings_size += [&] {
+					  if constexpr (std::same_as<std::remove_cvref_t<decltype(field)>, std::string>) {
+						  return field.size();
+					  }
+					  else {
+						  return std::size_t{ 0 };
+					  }
+				  }()),
+				 ...);
+			}, detail::tie_fields(record));
+		}
+		if (h.strings_size > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::length_error("serialized strings exceed 4 GiB; split the records into several buffers");
+		}
+		out.resize(h.strings_offset + h.strings_size);
+
+		std::byte *row = out.data() + h.rows_offset;
+		std::byte *heap = out.data() + h.strings_offset;
+		std::uint32_t heap_used = 0;
+		for (const T &record : records) {
+			[&]<std::size_t... I>(std::index_sequence<I...>) {
+				const auto fields = detail::tie_fields(record);
+				(
+					[&] {
+						const auto &field = std::get<I>(fields);
+						std::byte *slot = row + detail::slots<T>[I];
+						if constexpr (std::same_as<detail::field_t<T, I>, std::string>) {
+							const StringRef ref{ heap_used, static_cast<std::uint32_t>(field.size()) };
+							std::memcpy(slot, &ref, sizeof(ref));
+							if (!field.empty()) {
+								std::memcpy(heap + heap_used, field.data(), field.size());
+							}
+							heap_used += ref.length;
+						}
+						else {
+							std::memcpy(slot, &field, sizeof(field));
+						}
+					}(),
+					...);
+			}(std::make_index_sequence<detail::field_count<T>()>{});
+			row += h.row_size;
+		}
+	}
+
+	std::memcpy(out.data(), &h, sizeof(h));
+	return out;
+}
+
+template<SerializableConcept T>
+std::vector<std::byte> write(const std::vector<T> &records) {
+	return write(std::span<const T>(records));
+}
+
+// Zero-copy reader for string records; the buffer has to outlive it.
+template<StringRecordConcept T>
+class RecordReader {
+public:
+	explicit RecordReader(std::span<const std::byte> bytes) : header_(detail::check_header<T>(bytes, Kind::strings)) {
+		rows_ = bytes.data() + header_.rows_offset;
+		heap_ = reinterpret_cast<const char *>(bytes.data() + header_.strings_offset);
+		// validate every string once so get<I>() can skip bounds checks
+		for (std::size_t i = 0; i < size(); ++i) {
+			[&]<std::size_t... I>(std::index_sequence<I...>) {
+				(check_slot<I>(i), ...);
+			}(std::make_index_sequence<detail::field_count<T>()>{});
+		}
+	}
+
+	std::size_t size() const {
+		return static_cast<std::size_t>(header_.count);
+	}
+
+	// Field I of record `row`: a string_view into the buffer for string fields, the value otherwise.
+	template<std::size_t I>
+	auto get(std::size_t row) const {
+		const std::byte *slot = rows_ + row * header_.row_size + detail::slots<T>[I];
+		if constexpr (std::same_as<detail::field_t<T, I>, std::string>) {
+			StringRef ref;
+			std::memcpy(&ref, slot, sizeof(ref));
+			return std::string_view(heap_ + ref.offset, ref.length);
+		}
+		else {
+			detail::field_t<T, I> value;
+			std::memcpy(&value, slot, sizeof(value));
+			return value;
+		}
+	}
+
+	// Record `row` materialized as a T.
+	T operator[](std::size_t row) const {
+		T record{};
+		[&]<std::size_t... I>(std::index_sequence<I...>) {
+			auto fields = detail::tie_fields(record);
+			((std::get<I>(fields) = detail::field_t<T, I>(get<I>(row))), ...);
+		}(std::make_index_sequence<detail::field_count<T>()>{});
+		return record;
+	}
+
+private:
+	template<std::size_t I>
+	void check_slot(std::size_t row) const {
+		if constexpr (std::same_as<detail::field_t<T, I>, std::string>) {
+			StringRef ref;
+			std::memcpy(&ref, rows_ + row * header_.row_size + detail::slots<T>[I], sizeof(ref));
+			if (ref.offset > header_.strings_size || ref.length > header_.strings_size - ref.offset) {
+				detail::malformed("string field points outside the heap");
+			}
+		}
+	}
+
+	Header header_;
+	const std::byte *rows_{};
+	const char *heap_{};
+};
+
+// Reads records back without copying them: span<const T> for trivial records, RecordReader<T> for string records.
+template<SerializableConcept T>
+auto view(std::span<const std::byte> bytes) {
+	if constexpr (TrivialRecordConcept<T>) {
+		const Header h = detail::check_header<T>(bytes, Kind::trivial);
+		const std::byte *rows = bytes.data() + h.rows_offset;
+		if (reinterpret_cast<std::uintptr_t>(rows) % alignof(T) != 0) {
+			throw std::runtime_error("serialized records are not aligned for the requested type");
+		}
+		return std::span<const T>(reinterpret_cast<const T *>(rows), static_cast<std::size_t>(h.count));
+	}
+	else {
+		return RecordReader<T>(bytes);
+	}
+}
+
+// Copies the records back out.
+template<SerializableConcept T>
+std::vector<T> read(std::span<const std::byte> bytes) {
+	auto records = view<T>(bytes);
+	if constexpr (TrivialRecordConcept<T>) {
+		return { records.begin(), records.end() };
+	}
+	else {
+		std::vector<T> out;
+		out.reserve(records.size());
+		for (std::size_t i = 0; i < records.size(); ++i) {
+			out.push_back(records[i]);
+		}
+		return out;
+	}
+}
+
+} // namespace serial
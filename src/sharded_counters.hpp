@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//================================
+// 			ADD KERNEL
+//================================
+namespace counters_detail {
+
+template<std::integral T>
+T wrapping_add(T a, T b) {
+	using U = std::make_unsigned_t<T>;
+	return static_cast<T>(static_cast<U>(a) + static_cast<U>(b));
+}
+
+// acc[i] += row[i] (wrapping) for i < n. Other threads may be storing into row, so every cell is read with a
+// relaxed atomic load; with AVX2 a vector's worth of those loads is gathered into a buffer and added in one go.
+template<std::integral T>
+void accumulate(T *acc, T *row, std::size_t n) {
+	std::size_t i = 0;
+#if defined(__AVX2__)
+	if constexpr (sizeof(T) == 8 || sizeof(T) == 4) {
+		constexpr std::size_t W = 32 / sizeof(T);
+		alignas(32) T lanes[W];
+		for (const std::size_t end = n / W * W; i < end; i += W) {
+			for (std::size_t k = 0; k < W; ++k) {
+				lanes[k] = std::atomic_ref<T>(row[i + k]).load(std::memory_order_relaxed);
+			}
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc + i));
+			const __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes));
+			const __m256i sum = sizeof(T) == 8 ? _mm256_add_epi64(a, r) : _mm256_add_epi32(a, r);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(acc + i), sum);
+		}
+	}
+#endif
+	for (; i < n; ++i) {
+		acc[i] = wrapping_add(acc[i], std::atomic_ref<T>(row[i]).load(std::memory_order_relaxed));
+	}
+}
+
+// Small per-thread ids, handed out on a thread's first update and returned when it exits, so the live threads
+// hold distinct ids from 0 up.
+class ThreadSlots {
+public:
+	static std::size_t current() {
+		thread_local const Slot slot;
+		return slot.id;
+	}
+
+private:
+	struct Slot {
+		std::size_t id;
+
+		Slot() : id(acquire()) {}
+
+		~Slot() {
+			release(id);
+		}
+	};
+
+	static std::mutex &mutex() {
+		static std::mutex m;
+		return m;
+	}
+
+	static std::vector<bool> &used() {
+		static std::vector<bool> u;
+		return u;
+	}
+
+	static std::size_t acquire() {
+		std::lock_guard lock(mutex());
+		auto &u = used();
+		const auto it = std::find(u.begin(), u.end(), false);
+		const auto id = static_cast<std::size_t>(it - u.begin());
+		if (it == u.end()) {
+			u.push_back(true);
+		}
+		else {
+			*it = true;
+		}
+		return id;
+	}
+
+	static void release(std::size_t id) {
+		std::lock_guard lock(mutex());
+		used()[id] = false;
+	}
+};
+
+} // namespace counters_detail
+
+//================================
+// 			SHARDED COUNTERS
+//================================
+// An array of counters for many threads to bump at once without bouncing cache lines between them. Every shard
+// is a full copy of the array starting on its own cache line, and each live thread owns one shard (by its
+// ThreadSlots id), so an update is a relaxed load and store on a line no other thread writes. Threads beyond
+// the shard count share one overflow shard through relaxed fetch_add. Reads sum the shards on demand with the
+// vector add kernel, so they are O(shards x counters): meant for the occasional report, not a hot path. A read
+// racing updates returns, per counter, some value between the totals before and after those updates.
+template<std::integral T = std::int64_t>
+class ShardedCounters {
+public:
+	static constexpr std::size_t cache_line = 64;
+
+	explicit ShardedCounters(std::size_t counters,
+							 std::size_t shards = std::max(1u, std::thread::hardware_concurrency()))
+		: counters_(counters), stride_((counters * sizeof(T) + cache_line - 1) / cache_line * cache_line / sizeof(T)),
+		  shards_(std::max<std::size_t>(shards, 1)) {
+		const std::size_t bytes = std::max<std::size_t>((shards_ + 1) * stride_ * sizeof(T), cache_line);
+		cells_.reset(static_cast<T *>(::operator new[](bytes, std::align_val_t{ cache_line })));
+		std::memset(cells_.get(), 0, bytes);
+	}
+
+	std::size_t size() const {
+		return counters_;
+	}
+
+	// Exclusively owned shards; one more is shared by threads beyond these.
+	std::size_t shards() const {
+		return shards_;
+	}
+
+	void add(std::size_t counter, T delta = 1) {
+		assert(counter < counters_);
+		const std::size_t slot = counters_detail::ThreadSlots::current();
+		if (slot < shards_) {
+			std::atomic_ref<T> cell(cells_[slot * stride_ + counter]);
+			cell.store(counters_detail::wrapping_add(cell.load(std::memory_order_relaxed), delta),
+					   std::memory_order_relaxed);
+		}
+		else {
+			std::atomic_ref<T>(cells_[shards_ * stride_ + counter]).fetch_add(delta, std::memory_order_relaxed);
+		}
+	}
+
+	T value(std::size_t counter) const {
+		assert(counter < counters_);
+		T sum = 0;
+		for (std::size_t s = 0; s <= shards_; ++s) {
+			sum = counters_detail::wrapping_add(
+				sum, std::atomic_ref<T>(cells_[s * stride_ + counter]).load(std::memory_order_relaxed));
+		}
+		return sum;
+	}
+
+	// out[i] = value(i) for every counter, shard rows merged with the vector add kernel.
+	void values(std::span<T> out) const {
+		assert(out.size() >= counters_);
+		std::fill_n(out.begin(), counters_, T{ 0 });
+		for (std::size_t s = 0; s <= shards_; ++s) {
+			counters_detail::accumulate(out.data(), cells_.get() + s * stride_, counters_);
+		}
+	}
+
+	std::vector<T> values() const {
+		std::vector<T> out(counters_);
+		values(out);
+		return out;
+	}
+
+	// Zeroes every counter. Not atomic with respect to concurrent add(): call it while no thread is updating.
+	void reset() {
+		for (std::size_t i = 0; i < (shards_ + 1) * stride_; ++i) {
+			std::atomic_ref<T>(cells_[i]).store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct AlignedDelete {
+		void operator()(T *p) const {
+			::operator delete[](p, std::align_val_t{ cache_line });
+		}
+	};
+
+	std::size_t counters_;
+	std::size_t stride_; // counters rounded up to whole cache lines
+	std::size_t shards_;
+	std::unique_ptr<T[], AlignedDelete> cells_; // (shards_ + 1) rows of stride_
+};
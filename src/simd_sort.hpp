@@ -0,0 +1,478 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+
+//================================
+// 			SIMD SORT
+//================================
+// Unstable in-place sort of integral keys: a quicksort whose partition step works on whole AVX2 vectors (compare
+// against the pivot, pack both sides with a permutation table, store them to the two ends of the range), with
+// partitions of up to two vectors finished by a bitonic sorting network held in registers. 32- and 64-bit keys
+// take the vector path; other widths, and builds without AVX2, run the same quicksort with a branchless scalar
+// partition. Recursion deeper than 2 log2(n) hands the range to std::sort, so adversarial inputs stay
+// O(n log n). Large inputs sort runs in parallel, then merge run pairs in parallel slices.
+namespace simd_sort_detail {
+
+inline constexpr std::size_t parallel_grain = 64 * 1024;
+
+template<std::integral T>
+inline constexpr bool vectorized =
+#if defined(__AVX2__)
+	sizeof(T) == 4 || sizeof(T) == 8;
+#else
+	false;
+#endif
+
+// Moves the keys <= pivot to the front and returns how many there are.
+template<std::integral T>
+std::size_t partition_scalar(T *a, std::size_t n, T pivot) {
+	std::size_t left = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		const T x = a[i];
+		const bool le = x <= pivot;
+		a[i] = a[left];
+		a[left] = x;
+		left += le;
+	}
+	return left;
+}
+
+template<std::integral T>
+void insertion_sort(T *a, std::size_t n) {
+	for (std::size_t i = 1; i < n; ++i) {
+		const T x = a[i];
+		std::size_t j = i;
+		for (; j > 0 && a[j - 1] > x; --j) {
+			a[j] = a[j - 1];
+		}
+		a[j] = x;
+	}
+}
+
+#if defined(__AVX2__)
+// Keys live in registers XORed with `bias` (the sign bit for unsigned types) so signed compares order them.
+template<std::integral T>
+struct Lanes {
+	static constexpr std::size_t count = 32 / sizeof(T);
+
+	static __m256i set1(T x) {
+		if constexpr (sizeof(T) == 4) {
+			return _mm256_set1_epi32(static_cast<std::int32_t>(x));
+		}
+		else {
+			return _mm256_set1_epi64x(static_cast<std::int64_t>(x));
+		}
+	}
+
+	static __m256i bias() {
+		return set1(std::is_signed_v<T> ? T{ 0 } : static_cast<T>(T{ 1 } << (8 * sizeof(T) - 1)));
+	}
+
+	static __m256i gt(__m256i a, __m256i b) {
+		if constexpr (sizeof(T) == 4) {
+			return _mm256_cmpgt_epi32(a, b);
+		}
+		else {
+			return _mm256_cmpgt_epi64(a, b);
+		}
+	}
+
+	static __m256i eq(__m256i a, __m256i b) {
+		if constexpr (sizeof(T) == 4) {
+			return _mm256_cmpeq_epi32(a, b);
+		}
+		else {
+			return _mm256_cmpeq_epi64(a, b);
+		}
+	}
+
+	static unsigned mask(__m256i m) {
+		if constexpr (sizeof(T) == 4) {
+			return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+		}
+		else {
+			return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+		}
+	}
+};
+
+using Permutation = std::array<std::int32_t, 8>; // 32-bit lane indices for _mm256_permutevar8x32_epi32
+
+// Key lane `to` of the result takes key lane from[to]; 64-bit keys move as pairs of 32-bit lanes.
+template<std::size_t W>
+constexpr Permutation key_permutation(const std::array<std::size_t, W> &from) {
+	constexpr std::size_t f = 8 / W;
+	Permutation p{};
+	for (std::size_t to = 0; to < W; ++to) {
+		for (std::size_t s = 0; s < f; ++s) {
+			p[to * f + s] = static_cast<std::int32_t>(from[to] * f + s);
+		}
+	}
+	return p;
+}
+
+// compress[m] packs the key lanes whose bit in m is clear to the front, in order, and the others after them.
+template<std::size_t W>
+inline constexpr auto compress = [] {
+	std::array<Permutation, std::size_t{ 1 } << W> table{};
+	for (std::size_t m = 0; m < table.size(); ++m) {
+		std::array<std::size_t, W> from{};
+		std::size_t o = 0;
+		for (std::size_t pass = 0; pass < 2; ++pass) {
+			for (std::size_t k = 0; k < W; ++k) {
+				if (((m >> k) & 1) == pass) {
+					from[o++] = k;
+				}
+			}
+		}
+		table[m] = key_permutation<W>(from);
+	}
+	return table;
+}();
+
+// One compare-exchange layer: every key lane meets lane partner (from `partner`) and keeps the min or the max.
+struct Layer {
+	Permutation partner;
+	Permutation take_max; // -1 on every 32-bit lane of a key that keeps the max
+};
+
+template<std::size_t W>
+constexpr Layer make_layer(std::size_t k, std::size_t j, bool clean) {
+	std::array<std::size_t, W> from{};
+	std::array<bool, W> take_max{};
+	for (std::size_t i = 0; i < W; ++i) {
+		from[i] = i ^ j;
+		const bool ascending = clean || (i & k) == 0;
+		take_max[i] = (i > from[i]) == ascending;
+	}
+	Layer layer{ key_permutation<W>(from), {} };
+	for (std::size_t l = 0; l < 8; ++l) {
+		layer.take_max[l] = take_max[l / (8 / W)] ? -1 : 0;
+	}
+	return layer;
+}
+
+// Bitonic sort of one register: stages k = 2 .. W, each with distances j = k/2 .. 1.
+template<std::size_t W>
+inline constexpr auto sort_layers = [] {
+	constexpr std::size_t log_w = std::bit_width(W) - 1;
+	std::array<Layer, log_w *(log_w + 1) / 2> layers{};
+	std::size_t l = 0;
+	for (std::size_t k = 2; k <= W; k *= 2) {
+		for (std::size_t j = k / 2; j >= 1; j /= 2) {
+			layers[l++] = make_layer<W>(k, j, false);
+		}
+	}
+	return layers;
+}();
+
+// Sorts a bitonic register ascending.
+template<std::size_t W>
+inline constexpr auto clean_layers = [] {
+	std::array<Layer, std::bit_width(W) - 1> layers{};
+	std::size_t l = 0;
+	for (std::size_t j = W / 2; j >= 1; j /= 2) {
+		layers[l++] = make_layer<W>(W, j, true);
+	}
+	return layers;
+}();
+
+template<std::size_t W>
+inline constexpr Permutation reverse = [] {
+	std::array<std::size_t, W> from{};
+	for (std::size_t i = 0; i < W; ++i) {
+		from[i] = W - 1 - i;
+	}
+	return key_permutation<W>(from);
+}();
+
+inline __m256i load_permutation(const Permutation &p) {
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p.data()));
+}
+
+template<std::integral T>
+__m256i apply_layer(__m256i v, const Layer &layer) {
+	const __m256i p = _mm256_permutevar8x32_epi32(v, load_permutation(layer.partner));
+	const __m256i g = Lanes<T>::gt(v, p);
+	const __m256i lo = _mm256_blendv_epi8(v, p, g), hi = _mm256_blendv_epi8(p, v, g);
+	return _mm256_blendv_epi8(lo, hi, load_permutation(layer.take_max));
+}
+
+// Sorts n <= 2 * lanes keys: pads two registers with the largest key, sorts each, then merges them.
+template<std::integral T>
+void sort_network(T *a, std::size_t n) {
+	using L = Lanes<T>;
+	constexpr std::size_t W = L::count;
+	assert(n <= 2 * W);
+	alignas(32) T buf[2 * W];
+	std::fill_n(buf, 2 * W, std::numeric_limits<T>::max());
+	std::copy_n(a, n, buf);
+	const __m256i bias = L::bias();
+	__m256i lo = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<const __m256i *>(buf)), bias);
+	__m256i hi = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<const __m256i *>(buf + W)), bias);
+	for (const Layer &layer : sort_layers<W>) {
+		lo = apply_layer<T>(lo, layer);
+		hi = apply_layer<T>(hi, layer);
+	}
+	// lo followed by reversed hi is bitonic: the lane-wise min and max are two bitonic halves, lo <= hi
+	hi = _mm256_permutevar8x32_epi32(hi, load_permutation(reverse<W>));
+	const __m256i g = L::gt(lo, hi);
+	const __m256i min = _mm256_blendv_epi8(lo, hi, g), max = _mm256_blendv_epi8(hi, lo, g);
+	lo = min;
+	hi = max;
+	for (const Layer &layer : clean_layers<W>) {
+		lo = apply_layer<T>(lo, layer);
+		hi = apply_layer<T>(hi, layer);
+	}
+	_mm256_store_si256(reinterpret_cast<__m256i *>(buf), _mm256_xor_si256(lo, bias));
+	_mm256_store_si256(reinterpret_cast<__m256i *>(buf + W), _mm256_xor_si256(hi, bias));
+	std::copy_n(buf, n, a);
+}
+
+// Same contract as partition_scalar, for n >= 2 * lanes. The first and last vectors are set aside, leaving a
+// vector of free space at each end; each step reads a vector from the end with less free space, so both ends
+// then have room for a full-width store of the packed vector (keys <= pivot go left, the rest right). The
+// unread remainder and the two saved vectors fill the gap in the middle at the end.
+template<std::integral T>
+std::size_t partition_vector(T *a, std::size_t n, T pivot) {
+	using L = Lanes<T>;
+	constexpr std::size_t W = L::count;
+	assert(n >= 2 * W);
+	const __m256i bias = L::bias(), p = _mm256_xor_si256(L::set1(pivot), bias);
+
+	T saved[3 * W];
+	std::copy_n(a, W, saved);
+	std::copy_n(a + n - W, W, saved + W);
+	T *read_left = a + W, *read_right = a + n - W;
+	T *write_left = a, *write_right = a + n;
+	while (static_cast<std::size_t>(read_right - read_left) >= W) {
+		__m256i v;
+		if (read_left - write_left <= write_right - read_right) {
+			v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(read_left));
+			read_left += W;
+		}
+		else {
+			read_right -= W;
+			v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(read_right));
+		}
+		const unsigned m = L::mask(L::gt(_mm256_xor_si256(v, bias), p));
+		const __m256i packed = _mm256_permutevar8x32_epi32(v, load_permutation(compress<W>[m]));
+		const std::size_t le = W - static_cast<std::size_t>(std::popcount(m));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(write_left), packed);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(write_right - W), packed);
+		write_left += le;
+		write_right -= W - le;
+	}
+
+	const std::size_t rest = static_cast<std::size_t>(read_right - read_left);
+	std::copy_n(read_left, rest, saved + 2 * W);
+	for (std::size_t i = 0; i < 2 * W + rest; ++i) {
+		if (saved[i] <= pivot) {
+			*write_left++ = saved[i];
+		}
+		else {
+			*--write_right = saved[i];
+		}
+	}
+	return static_cast<std::size_t>(write_left - a);
+}
+#endif
+
+template<std::integral T>
+inline constexpr std::size_t small_size = vectorized<T> ? 64 / sizeof(T) : 16;
+
+template<std::integral T>
+void small_sort(T *a, std::size_t n) {
+#if defined(__AVX2__)
+	if constexpr (vectorized<T>) {
+		sort_network(a, n);
+		return;
+	}
+#endif
+	insertion_sort(a, n);
+}
+
+template<std::integral T>
+std::size_t partition(T *a, std::size_t n, T pivot) {
+#if defined(__AVX2__)
+	if constexpr (vectorized<T>) {
+		return partition_vector(a, n, pivot);
+	}
+#endif
+	return partition_scalar(a, n, pivot);
+}
+
+template<std::integral T>
+T median_of_three(T a, T b, T c) {
+	return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+template<std::integral T>
+void quicksort(T *a, std::size_t n, int depth) {
+	while (n > small_size<T>) {
+		if (depth-- == 0) {
+			std::sort(a, a + n);
+			return;
+		}
+		const T pivot = median_of_three(a[n / 4], a[n / 2], a[n / 4 * 3]);
+		std::size_t mid = partition(a, n, pivot);
+		if (mid == n) {
+			// pivot is the largest key: split off the keys equal to it, which are then in place
+			if (pivot == std::numeric_limits<T>::min()) {
+				return;
+			}
+			n = partition(a, n, static_cast<T>(pivot - 1));
+			continue;
+		}
+		if (mid < n - mid) {
+			quicksort(a, mid, depth);
+			a += mid;
+			n -= mid;
+		}
+		else {
+			quicksort(a + mid, n - mid, depth);
+			n = mid;
+		}
+	}
+	small_sort(a, n);
+}
+
+template<std::integral T>
+void sort_serial(std::span<T> keys) {
+	quicksort(keys.data(), keys.size(), 2 * static_cast<int>(std::bit_width(keys.size())));
+}
+
+// Number of items taken from a for the first k outputs of merging a and b (ties taken from a first).
+template<typename T>
+std::size_t co_rank(std::size_t k, std::span<const T> a, std::size_t b_size, const T *b) {
+	std::size_t lo = k > b_size ? k - b_size : 0, hi = std::min(k, a.size());
+	while (lo < hi) {
+		const std::size_t i = lo + (hi - lo) / 2;
+		if (a[i] > b[k - i - 1]) {
+			hi = i;
+		}
+		else {
+			lo = i + 1;
+		}
+	}
+	return lo;
+}
+
+// Sorts runs of about n / pool size keys in parallel, then merges pairs of runs, each round split into
+// parallel_grain output slices located in both inputs by binary search (merge path).
+template<std::integral T>
+void sort_parallel(std::span<T> keys, std::size_t runs) {
+	const std::size_t n = keys.size();
+	std::vector<std::size_t> bounds(runs + 1);
+	for (std::size_t r = 0; r <= runs; ++r) {
+		bounds[r] = r * n / runs;
+	}
+	parallel_for(runs, 1, [&](std::size_t rb, std::size_t re) {
+		for (std::size_t r = rb; r < re; ++r) {
+			sort_serial(keys.subspan(bounds[r], bounds[r + 1] - bounds[r]));
+		}
+	});
+
+	std::vector<T> tmp(n);
+	std::span<T> src = keys, dst = tmp;
+	for (std::size_t width = 1; width < runs; width *= 2) {
+		const std::size_t slices = (n + parallel_grain - 1) / parallel_grain;
+		parallel_for(slices, 1, [&](std::size_t sb, std::size_t se) {
+			const std::size_t out_begin = sb * parallel_grain, out_end = std::min(n, se * parallel_grain);
+			for (std::size_t g = 0; g < runs; g += 2 * width) {
+				const std::size_t first = bounds[g], middle = bounds[std::min(runs, g + width)];
+				const std::size_t last = bounds[std::min(runs, g + 2 * width)];
+				if (last <= out_begin || first >= out_end) {
+					continue;
+				}
+				const std::span<const T> a = src.subspan(first, middle - first);
+				const T *b = src.data() + middle;
+				const std::size_t b_size = last - middle;
+				const std::size_t k0 = std::max(first, out_begin) - first, k1 = std::min(last, out_end) - first;
+				const std::size_t i0 = co_rank(k0, a, b_size, b), i1 = co_rank(k1, a, b_size, b);
+				std::merge(a.begin() + i0, a.begin() + i1, b + (k0 - i0), b + (k1 - i1), dst.begin() + first + k0);
+			}
+		});
+		std::swap(src, dst);
+	}
+	if (src.data() != keys.data()) {
+		std::copy(src.begin(), src.end(), keys.begin());
+	}
+}
+
+// Order-preserving map of a key to an unsigned integer of the same width.
+template<std::integral Key>
+std::make_unsigned_t<Key> ordered(Key key) {
+	using U = std::make_unsigned_t<Key>;
+	constexpr U flip = std::is_signed_v<Key> ? static_cast<U>(U{ 1 } << (8 * sizeof(Key) - 1)) : U{ 0 };
+	return static_cast<U>(static_cast<U>(key) ^ flip);
+}
+
+template<std::integral Key>
+Key from_ordered(std::make_unsigned_t<Key> u) {
+	return static_cast<Key>(static_cast<std::make_unsigned_t<Key>>(u ^ ordered(Key{ 0 })));
+}
+
+} // namespace simd_sort_detail
+
+// Sorts keys ascending in place (unstable), on the current pool above two parallel grains of keys.
+template<std::integral T>
+void simd_sort(std::span<T> keys) {
+	using namespace simd_sort_detail;
+	const std::size_t runs = std::min(keys.size() / parallel_grain, ThreadPool::current().size());
+	if (runs <= 1) {
+		sort_serial(keys);
+	}
+	else {
+		sort_parallel(keys, runs);
+	}
+}
+
+// Sorts keys ascending and applies the same permutation to values; the order of equal keys is unspecified.
+// Keys and values of up to 4 bytes are packed into one 64-bit key (key high, value low) and go through
+// simd_sort; wider pairs go through radix_sort_pairs on order-preserving unsigned copies of the keys.
+template<std::integral Key, typename Value>
+	requires std::is_trivially_copyable_v<Value>
+void simd_sort_pairs(std::span<Key> keys, std::span<Value> values) {
+	using namespace simd_sort_detail;
+	assert(keys.size() == values.size());
+	const std::size_t n = keys.size();
+	if constexpr (sizeof(Key) <= 4 && sizeof(Value) <= 4) {
+		std::vector<std::uint64_t> packed(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			std::uint32_t v = 0;
+			std::memcpy(&v, &values[i], sizeof(Value));
+			packed[i] = static_cast<std::uint64_t>(ordered(keys[i])) << 32 | v;
+		}
+		simd_sort(std::span(packed));
+		for (std::size_t i = 0; i < n; ++i) {
+			const auto v = static_cast<std::uint32_t>(packed[i]);
+			keys[i] = from_ordered<Key>(static_cast<std::make_unsigned_t<Key>>(packed[i] >> 32));
+			std::memcpy(&values[i], &v, sizeof(Value));
+		}
+	}
+	else {
+		std::vector<std::make_unsigned_t<Key>> unsigned_keys(n);
+		std::ranges::transform(keys, unsigned_keys.begin(), [](Key k) { return ordered(k); });
+		radix_sort_pairs(std::span(unsigned_keys), values);
+		std::ranges::transform(unsigned_keys, keys.begin(), [](auto u) { return from_ordered<Key>(u); });
+	}
+}
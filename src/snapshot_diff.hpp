@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hash_join.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "string_hash.hpp"
+#include "user.hpp"
+
+//================================
+// 			SNAPSHOT DIFF
+//================================
+// Records are identified by username and compared by a content hash. A SnapshotIndex keeps its records sorted by
+// username hash and cut into 2^block_bits blocks on the top hash bits, so block j covers the same key range in
+// every version of the data. Each block has a digest (the wrapping sum of its records' mixed key/content hashes)
+// and the digests form a binary tree whose parents are the sums of their children. Diffing walks both trees from
+// the root and only opens blocks whose digests differ, so a few thousand changes out of millions of records
+// touch a few thousand small blocks. The digests alone are what a replica needs to exchange to find out which
+// blocks to ship.
+struct SnapshotOptions {
+	int block_bits = -1; // -1: about 64 records per block
+};
+
+class SnapshotIndex {
+public:
+	SnapshotIndex() = default;
+	SnapshotIndex(SnapshotIndex &&) = default;
+	SnapshotIndex &operator=(SnapshotIndex &&) = default;
+	SnapshotIndex(const SnapshotIndex &) = delete; // keys may view strings owned by this object
+	SnapshotIndex &operator=(const SnapshotIndex &) = delete;
+
+	// Hashes and sorts `users`. The index keeps string_views into the records' username fields when they are
+	// strings, so `users` has to outlive it. `content_hash` decides what counts as a change; the default covers
+	// username and email.
+	template<std::ranges::random_access_range R, typename ContentHash = UserHash>
+		requires UserTypeConcept<std::ranges::range_value_t<R>>
+	static SnapshotIndex build(const R &users, SnapshotOptions options = {}, ContentHash content_hash = {}) {
+		SnapshotIndex index;
+		const std::size_t n = std::ranges::size(users);
+		index.keys_ = join_detail::key_column(users, JoinKey::username);
+
+		index.rows_.resize(n);
+		std::iota(index.rows_.begin(), index.rows_.end(), std::size_t{ 0 });
+		index.key_hashes_ = index.keys_.hashes;
+		radix_sort_pairs(std::span(index.key_hashes_), std::span(index.rows_));
+		// equal hashes are nearly always equal keys; order true collisions by key so both sides agree
+		for (std::size_t i = 0; i < n;) {
+			std::size_t j = i + 1;
+			while (j < n && index.key_hashes_[j] == index.key_hashes_[i]) {
+				++j;
+			}
+			if (j - i > 1) {
+				std::sort(index.rows_.begin() + i, index.rows_.begin() + j,
+						  [&](std::size_t a, std::size_t b) { return index.keys_.keys[a] < index.keys_.keys[b]; });
+			}
+			i = j;
+		}
+
+		index.content_hashes_.resize(n);
+		parallel_for(n, 16 * 1024, [&](std::size_t b, std::size_t e) {
+			for (std::size_t i = b; i < e; ++i) {
+				const auto &user = std::ranges::begin(users)[index.rows_[i]];
+				index.content_hashes_[i] = static_cast<std::uint64_t>(content_hash(user));
+			}
+		});
+
+		index.block_bits_ = options.block_bits >= 0 ? std::min(options.block_bits, 24)
+													: std::min(static_cast<int>(std::bit_width(n / 64)), 24);
+		index.build_tree();
+		return index;
+	}
+
+	std::size_t size() const {
+		return rows_.size();
+	}
+
+	int block_bits() const {
+		return block_bits_;
+	}
+
+	// Digest of block `block` at tree depth `bits` (0 = root, block_bits() = leaves).
+	std::uint64_t digest(int bits, std::size_t block) const {
+		return levels_[static_cast<std::size_t>(block_bits_ - bits)][block];
+	}
+
+	std::uint64_t root_digest() const {
+		return digest(0, 0);
+	}
+
+	// Sorted positions [first, last) of the records in block `block` at depth `bits`.
+	std::pair<std::size_t, std::size_t> block_range(int bits, std::size_t block) const {
+		const int fold = block_bits_ - bits;
+		return { offsets_[block << fold], offsets_[(block + 1) << fold] };
+	}
+
+	std::size_t row(std::size_t position) const {
+		return rows_[position];
+	}
+
+	std::uint64_t key_hash(std::size_t position) const {
+		return key_hashes_[position];
+	}
+
+	std::string_view key(std::size_t position) const {
+		return keys_.keys[rows_[position]];
+	}
+
+	std::uint64_t content_hash(std::size_t position) const {
+		return content_hashes_[position];
+	}
+
+private:
+	void build_tree() {
+		const std::size_t blocks = std::size_t{ 1 } << block_bits_;
+		const int shift = 64 - block_bits_;
+		offsets_.resize(blocks + 1);
+		parallel_for(blocks + 1, 4096, [&](std::size_t b, std::size_t e) {
+			for (std::size_t j = b; j < e; ++j) {
+				if (j == 0 || j == blocks) {
+					offsets_[j] = j == 0 ? 0 : key_hashes_.size();
+					continue;
+				}
+				const std::uint64_t first_hash = static_cast<std::uint64_t>(j) << shift;
+				offsets_[j] = static_cast<std::size_t>(
+					std::lower_bound(key_hashes_.begin(), key_hashes_.end(), first_hash) - key_hashes_.begin());
+			}
+		});
+
+		levels_.assign(1, std::vector<std::uint64_t>(blocks));
+		auto &leaves = levels_[0];
+		parallel_for(blocks, 256, [&](std::size_t b, std::size_t e) {
+			for (std::size_t j = b; j < e; ++j) {
+				std::uint64_t sum = 0;
+				for (std::size_t i = offsets_[j]; i < offsets_[j + 1]; ++i) {
+					sum += string_hash::combine(key_hashes_[i], content_hashes_[i]);
+				}
+				leaves[j] = sum;
+			}
+		});
+		while (levels_.back().size() > 1) {
+			const auto &child = levels_.back();
+			std::vector<std::uint64_t> parent(child.size() / 2);
+			for (std::size_t j = 0; j < parent.size(); ++j) {
+				parent[j] = child[2 * j] + child[2 * j + 1];
+			}
+			levels_.push_back(std::move(parent));
+		}
+	}
+
+	join_detail::KeyColumn keys_;
+	std::vector<std::size_t> rows_;				 // sorted position -> source row
+	std::vector<std::uint64_t> key_hashes_;		 // sorted
+	std::vector<std::uint64_t> content_hashes_; // by sorted position
+	std::vector<std::size_t> offsets_;			 // leaf block -> first sorted position
+	std::vector<std::vector<std::uint64_t>> levels_; // levels_[0] = leaves, levels_.back() = root
+	int block_bits_{};
+};
+
+// Row indices into the two source ranges.
+struct SnapshotDiff {
+	std::vector<std::size_t> added;						// rows of `after`
+	std::vector<std::size_t> removed;					// rows of `before`
+	std::vector<std::pair<std::size_t, std::size_t>> changed; // (before row, after row)
+	std::size_t blocks_compared{};						// leaf blocks that had to be opened
+};
+
+namespace snapshot_detail {
+
+inline void mismatched_blocks(const SnapshotIndex &before, const SnapshotIndex &after, int bits, int depth,
+							  std::size_t block, std::vector<std::size_t> &out) {
+	if (before.digest(depth, block) == after.digest(depth, block)) {
+		return;
+	}
+	if (depth == bits) {
+		out.push_back(block);
+		return;
+	}
+	mismatched_blocks(before, after, bits, depth + 1, 2 * block, out);
+	mismatched_blocks(before, after, bits, depth + 1, 2 * block + 1, out);
+}
+
+// Merges one block of both sides in (key hash, key) order.
+inline void diff_block(const SnapshotIndex &before, const SnapshotIndex &after, int bits, std::size_t block,
+					   SnapshotDiff &out) {
+	auto [i, i_end] = before.block_range(bits, block);
+	auto [j, j_end] = after.block_range(bits, block);
+	auto less = [](std::uint64_t ha, std::string_view ka, std::uint64_t hb, std::string_view kb) {
+		return ha != hb ? ha < hb : ka < kb;
+	};
+	while (i < i_end && j < j_end) {
+		const auto hi = before.key_hash(i), hj = after.key_hash(j);
+		const auto ki = before.key(i), kj = after.key(j);
+		if (less(hi, ki, hj, kj)) {
+			out.removed.push_back(before.row(i++));
+		}
+		else if (less(hj, kj, hi, ki)) {
+			out.added.push_back(after.row(j++));
+		}
+		else {
+			if (before.content_hash(i) != after.content_hash(j)) {
+				out.changed.emplace_back(before.row(i), after.row(j));
+			}
+			++i;
+			++j;
+		}
+	}
+	for (; i < i_end; ++i) {
+		out.removed.push_back(before.row(i));
+	}
+	for (; j < j_end; ++j) {
+		out.added.push_back(after.row(j));
+	}
+}
+
+} // namespace snapshot_detail
+
+// Added, removed and changed records between two versions. Indexes built with different block_bits are compared
+// at the coarser of the two.
+inline SnapshotDiff snapshot_diff(const SnapshotIndex &before, const SnapshotIndex &after) {
+	const int bits = std::min(before.block_bits(), after.block_bits());
+	std::vector<std::size_t> blocks;
+	snapshot_detail::mismatched_blocks(before, after, bits, 0, 0, blocks);
+
+	std::vector<SnapshotDiff> parts(blocks.size());
+	parallel_for(blocks.size(), 64, [&](std::size_t b, std::size_t e) {
+		for (std::size_t k = b; k < e; ++k) {
+			snapshot_detail::diff_block(before, after, bits, blocks[k], parts[k]);
+		}
+	});
+
+	SnapshotDiff diff;
+	diff.blocks_compared = blocks.size();
+	for (const auto &part : parts) {
+		diff.added.insert(diff.added.end(), part.added.begin(), part.added.end());
+		diff.removed.insert(diff.removed.end(), part.removed.begin(), part.removed.end());
+		diff.changed.insert(diff.changed.end(), part.changed.begin(), part.changed.end());
+	}
+	return diff;
+}
+
+template<std::ranges::random_access_range R1, std::ranges::random_access_range R2>
+	requires UserTypeConcept<std::ranges::range_value_t<R1>> && UserTypeConcept<std::ranges::range_value_t<R2>>
+SnapshotDiff snapshot_diff(const R1 &before, const R2 &after) {
+	// one shared block size, so neither tree has to be folded
+	const std::size_t n = std::max<std::size_t>(std::ranges::size(before), std::ranges::size(after));
+	const int bits = std::min(static_cast<int>(std::bit_width(n / 64)), 24);
+	return snapshot_diff(SnapshotIndex::build(before, { .block_bits = bits }),
+						 SnapshotIndex::build(after, { .block_bits = bits }));
+}
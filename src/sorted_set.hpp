@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "simd_sort.hpp"
+
+//================================
+// 			SORTED SETS
+//================================
+// Intersection, union and difference of sorted id lists (strictly increasing, as produced by filters), written
+// to a caller-sized output and returning the output length. Lists of similar size are merged; when one list is
+// at least gallop_ratio times the other, each element of the short list is located in the long one by galloping
+// (exponential then binary search), so the cost follows the short list. With AVX2, intersection and difference
+// of 32/64-bit ids compare a whole vector of each list at once (every lane against every rotation of the other
+// vector) and pack the kept lanes with simd_sort's permutation table. Union stays a scalar merge: its output is
+// as large as both inputs, and every element has to be written in order anyway.
+namespace sorted_set_detail {
+
+inline constexpr std::size_t gallop_ratio = 32;
+
+// First index >= from whose element is >= x: probes from + 1, 2, 4, ..., then binary-searches the last step.
+template<std::integral T>
+std::size_t gallop(std::span<const T> s, std::size_t from, T x) {
+	std::size_t step = 1, lo = from, hi = from;
+	while (hi < s.size() && s[hi] < x) {
+		lo = hi + 1;
+		hi = from + step;
+		step *= 2;
+	}
+	hi = std::min(hi, s.size());
+	return static_cast<std::size_t>(std::lower_bound(s.begin() + lo, s.begin() + hi, x) - s.begin());
+}
+
+// small ∩ large, or small \ large (keep_found = false), one gallop per element of small.
+template<bool keep_found, std::integral T>
+std::size_t filter_galloping(std::span<const T> small, std::span<const T> large, T *out) {
+	std::size_t k = 0, p = 0;
+	for (const T x : small) {
+		p = gallop(large, p, x);
+		if ((p < large.size() && large[p] == x) == keep_found) {
+			out[k++] = x;
+		}
+	}
+	return k;
+}
+
+// Elements of a from i on whose presence in b, from j on, equals keep_found; appended at out[k].
+template<bool keep_found, std::integral T>
+std::size_t filter_merge(std::span<const T> a, std::span<const T> b, std::size_t i, std::size_t j, T *out,
+						 std::size_t k) {
+	while (i < a.size() && j < b.size()) {
+		if (a[i] < b[j]) {
+			if constexpr (!keep_found) {
+				out[k++] = a[i];
+			}
+			++i;
+		}
+		else if (b[j] < a[i]) {
+			++j;
+		}
+		else {
+			if constexpr (keep_found) {
+				out[k++] = a[i];
+			}
+			++i;
+			++j;
+		}
+	}
+	if constexpr (!keep_found) {
+		k = static_cast<std::size_t>(std::copy(a.begin() + i, a.end(), out + k) - out);
+	}
+	return k;
+}
+
+#if defined(__AVX2__)
+template<std::size_t W>
+inline constexpr auto rotations = [] {
+	std::array<simd_sort_detail::Permutation, W - 1> table{};
+	for (std::size_t r = 1; r < W; ++r) {
+		std::array<std::size_t, W> from{};
+		for (std::size_t i = 0; i < W; ++i) {
+			from[i] = (i + r) % W;
+		}
+		table[r - 1] = simd_sort_detail::key_permutation<W>(from);
+	}
+	return table;
+}();
+
+// Block merge: a vector of a stays current until b's vectors pass its last element, OR-ing together which of its
+// lanes matched any of them; then its kept lanes are packed and stored. Earlier b vectors end below a's current
+// vector and later ones start above it, so every match is seen. The scalar merge finishes from the first b
+// vector that matched the pending a vector. out must hold the result plus one vector of slack.
+template<bool keep_found, std::integral T>
+std::size_t filter_vector(std::span<const T> a, std::span<const T> b, T *out) {
+	using namespace simd_sort_detail;
+	using L = Lanes<T>;
+	constexpr std::size_t W = L::count;
+	constexpr unsigned all = (1u << W) - 1;
+	std::size_t i = 0, j = 0, k = 0, j_met = 0;
+	unsigned found = 0;
+	while (i + W <= a.size() && j + W <= b.size()) {
+		const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.data() + i));
+		const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.data() + j));
+		__m256i eq = L::eq(va, vb);
+		for (const auto &rotation : rotations<W>) {
+			eq = _mm256_or_si256(eq, L::eq(va, _mm256_permutevar8x32_epi32(vb, load_permutation(rotation))));
+		}
+		found |= L::mask(eq);
+		const T a_last = a[i + W - 1], b_last = b[j + W - 1];
+		if (a_last <= b_last) {
+			const unsigned keep = keep_found ? found : ~found & all;
+			const __m256i packed = _mm256_permutevar8x32_epi32(va, load_permutation(compress<W>[~keep & all]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), packed);
+			k += static_cast<std::size_t>(std::popcount(keep));
+			i += W;
+			found = 0;
+		}
+		if (b_last <= a_last) {
+			j += W;
+		}
+		if (found == 0) {
+			j_met = j; // nothing before j matches the current a vector
+		}
+	}
+	return filter_merge<keep_found>(a, b, i, j_met, out, k);
+}
+#endif
+
+template<bool keep_found, std::integral T>
+std::size_t filter(std::span<const T> a, std::span<const T> b, std::span<T> out) {
+	assert(out.size() >= (keep_found ? std::min(a.size(), b.size()) : a.size()));
+	if (a.size() * gallop_ratio <= b.size()) {
+		return filter_galloping<keep_found>(a, b, out.data());
+	}
+	if constexpr (keep_found) {
+		if (b.size() * gallop_ratio <= a.size()) {
+			return filter_galloping<true>(b, a, out.data());
+		}
+	}
+	else {
+		if (b.size() * gallop_ratio <= a.size()) {
+			// few removals: copy the runs of a between the elements of b
+			std::size_t k = 0, p = 0;
+			for (const T y : b) {
+				const std::size_t q = gallop(a, p, y);
+				k = static_cast<std::size_t>(std::copy(a.begin() + p, a.begin() + q, out.begin() + k) - out.begin());
+				p = q < a.size() && a[q] == y ? q + 1 : q;
+			}
+			return static_cast<std::size_t>(std::copy(a.begin() + p, a.end(), out.begin() + k) - out.begin());
+		}
+	}
+#if defined(__AVX2__)
+	if constexpr (sizeof(T) == 4 || sizeof(T) == 8) {
+		// the packed stores write a whole vector: go through a slack buffer unless out has room for one more
+		constexpr std::size_t W = simd_sort_detail::Lanes<T>::count;
+		const std::size_t bound = keep_found ? std::min(a.size(), b.size()) : a.size();
+		if (out.size() >= bound + W) {
+			return filter_vector<keep_found>(a, b, out.data());
+		}
+		std::vector<T> slack(bound + W);
+		const std::size_t k = filter_vector<keep_found>(a, b, slack.data());
+		std::copy_n(slack.begin(), k, out.begin());
+		return k;
+	}
+#endif
+	return filter_merge<keep_found>(a, b, 0, 0, out.data(), 0);
+}
+
+} // namespace sorted_set_detail
+
+// a ∩ b into out (at least min(a.size(), b.size()) long); returns its length.
+template<std::integral T>
+std::size_t sorted_intersection(std::span<const T> a, std::span<const T> b, std::span<T> out) {
+	return sorted_set_detail::filter<true>(a, b, out);
+}
+
+// a \ b into out (at least a.size() long); returns its length.
+template<std::integral T>
+std::size_t sorted_difference(std::span<const T> a, std::span<const T> b, std::span<T> out) {
+	return sorted_set_detail::filter<false>(a, b, out);
+}
+
+// a ∪ b into out (at least a.size() + b.size() long); returns its length.
+template<std::integral T>
+std::size_t sorted_union(std::span<const T> a, std::span<const T> b, std::span<T> out) {
+	using namespace sorted_set_detail;
+	assert(out.size() >= a.size() + b.size());
+	if (a.size() < b.size()) {
+		std::swap(a, b);
+	}
+	std::size_t i = 0, j = 0, k = 0;
+	if (b.size() * gallop_ratio <= a.size()) {
+		// copy the runs of a between the elements of b
+		for (const T y : b) {
+			const std::size_t q = gallop(a, i, y);
+			k = static_cast<std::size_t>(std::copy(a.begin() + i, a.begin() + q, out.begin() + k) - out.begin());
+			out[k++] = y;
+			i = q < a.size() && a[q] == y ? q + 1 : q;
+		}
+		j = b.size();
+	}
+	while (i < a.size() && j < b.size()) {
+		const T x = a[i], y = b[j];
+		out[k++] = std::min(x, y);
+		i += x <= y;
+		j += y <= x;
+	}
+	k = static_cast<std::size_t>(std::copy(a.begin() + i, a.end(), out.begin() + k) - out.begin());
+	return static_cast<std::size_t>(std::copy(b.begin() + j, b.end(), out.begin() + k) - out.begin());
+}
+
+// Allocating forms of the above.
+template<std::integral T>
+std::vector<T> sorted_intersection(std::span<const T> a, std::span<const T> b) {
+	std::vector<T> out(std::min(a.size(), b.size()));
+	out.resize(sorted_intersection(a, b, std::span(out)));
+	return out;
+}
+
+template<std::integral T>
+std::vector<T> sorted_difference(std::span<const T> a, std::span<const T> b) {
+	std::vector<T> out(a.size());
+	out.resize(sorted_difference(a, b, std::span(out)));
+	return out;
+}
+
+template<std::integral T>
+std::vector<T> sorted_union(std::span<const T> a, std::span<const T> b) {
+	std::vector<T> out(a.size() + b.size());
+	out.resize(sorted_union(a, b, std::span(out)));
+	return out;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "bench.hpp"
+#include "debounce.hpp"
+#include "digital_input.hpp"
+
+//================================
+// 			STARTUP CLOCK
+//================================
+// Fixed points before main. The first static constructor is marked by a priority-101 constructor, which runs
+// ahead of every ordinary static initializer in the executable. Process start comes from the kernel
+// (/proc/self/stat, clock-tick resolution, usually 10 ms), so "loader" is coarse and Linux only.
+namespace startup_detail {
+
+using clock = std::chrono::steady_clock;
+
+inline std::atomic<clock::rep> first_constructor{ 0 };
+
+inline void mark_first_constructor() {
+	clock::rep expected = 0;
+	first_constructor.compare_exchange_strong(expected, clock::now().time_since_epoch().count());
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+[[gnu::constructor(101)]] static void mark_first_constructor_early() {
+	mark_first_constructor();
+}
+#else
+inline const bool first_constructor_marked = (mark_first_constructor(), true);
+#endif
+
+// Process start on the steady clock; `first` is false where the kernel doesn't say.
+inline std::pair<bool, clock::time_point> process_start() {
+#if defined(__linux__)
+	std::ifstream stat("/proc/self/stat");
+	std::string text;
+	std::getline(stat, text);
+	// field 22 (starttime, ticks since boot); the command name in field 2 may contain spaces, so count after ')'
+	const std::size_t close = text.rfind(')');
+	if (close == std::string::npos) {
+		return { false, {} };
+	}
+	std::size_t at = close + 2, field = 3;
+	while (field < 22 && at < text.size()) {
+		at = text.find(' ', at) + 1;
+		if (at == 0) {
+			return { false, {} };
+		}
+		++field;
+	}
+	const double start_s = std::stod(text.substr(at)) / static_cast<double>(::sysconf(_SC_CLK_TCK));
+	timespec boot{};
+	::clock_gettime(CLOCK_BOOTTIME, &boot);
+	const auto steady_now = clock::now();
+	const double age_s = static_cast<double>(boot.tv_sec) + static_cast<double>(boot.tv_nsec) * 1e-9 - start_s;
+	return { true, steady_now - std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(age_s)) };
+#else
+	return { false, {} };
+#endif
+}
+
+} // namespace startup_detail
+
+//================================
+// 			STARTUP PROFILE
+//================================
+// Where the time from process start to the first read goes. Construct the profile first thing in main(); it
+// records "loader" (exec to the first static constructor) and "static_init" (first constructor to main), and
+// phase() adds named, timed steps after that: "config_load", "device_init", "first_poll" by convention.
+// Phases are kept in call order; time between them shows up as unattributed in the report.
+struct StartupPhase {
+	std::string name;
+	std::chrono::nanoseconds start{}; // from the report's origin
+	std::chrono::nanoseconds duration{};
+};
+
+struct StartupReport {
+	bool process_start_known{}; // origin is process start; otherwise the first static constructor
+	std::vector<StartupPhase> phases;
+	std::chrono::nanoseconds total{}; // origin to the end of the last phase
+
+	const StartupPhase *find(std::string_view name) const {
+		for (const auto &p : phases) {
+			if (p.name == name) {
+				return &p;
+			}
+		}
+		return nullptr;
+	}
+
+	std::chrono::nanoseconds unattributed() const {
+		auto rest = total;
+		for (const auto &p : phases) {
+			rest -= p.duration;
+		}
+		return rest;
+	}
+};
+
+class StartupProfile {
+public:
+	using clock = startup_detail::clock;
+
+	StartupProfile() : main_entry_(clock::now()) {
+		const auto marked = startup_detail::first_constructor.load();
+		const clock::time_point first_constructor =
+			marked != 0 ? clock::time_point(clock::duration(marked)) : main_entry_;
+		const auto [known, start] = startup_detail::process_start();
+		// the kernel's tick-rounded start can land after the first constructor; never let it
+		process_start_known_ = known;
+		origin_ = known ? std::min(start, first_constructor) : first_constructor;
+		if (known) {
+			record("loader", origin_, first_constructor);
+		}
+		record("static_init", first_constructor, main_entry_);
+	}
+
+	// Runs fn as the named phase and returns its result.
+	template<std::invocable F>
+	std::invoke_result_t<F> phase(std::string name, F &&fn) {
+		using R = std::invoke_result_t<F>;
+		const auto start = clock::now();
+		if constexpr (std::is_void_v<R>) {
+			std::invoke(std::forward<F>(fn));
+			record(std::move(name), start, clock::now());
+		}
+		else {
+			R result = std::invoke(std::forward<F>(fn));
+			record(std::move(name), start, clock::now());
+			return result;
+		}
+	}
+
+	void record(std::string name, clock::time_point start, clock::time_point end) {
+		phases_.push_back({ std::move(name), start - origin_, end - start });
+		end_ = std::max(end_, end);
+	}
+
+	StartupReport report() const {
+		return { process_start_known_, phases_, end_ - origin_ };
+	}
+
+private:
+	clock::time_point main_entry_;
+	clock::time_point origin_{};
+	clock::time_point end_{};
+	bool process_start_known_{};
+	std::vector<StartupPhase> phases_;
+};
+
+// The device half of startup: init() on every input, then one poll of all of them into `levels`.
+template<DigitalInputConcept DIn>
+void profile_device_startup(StartupProfile &profile, std::span<DIn> inputs, std::span<std::uint8_t> levels) {
+	profile.phase("device_init", [&] {
+		for (auto &input : inputs) {
+			input.init();
+		}
+	});
+	profile.phase("first_poll", [&] { poll_inputs(inputs, levels); });
+}
+
+inline std::string to_json(const StartupReport &report) {
+	using bench_json::number;
+	using bench_json::quote;
+	auto ms = [](std::chrono::nanoseconds d) { return number(std::chrono::duration<double, std::milli>(d).count()); };
+	std::string out = "{\n  \"origin\": ";
+	out += quote(report.process_start_known ? "process_start" : "first_static_constructor");
+	out += ",\n  \"total_ms\": " + ms(report.total);
+	out += ",\n  \"unattributed_ms\": " + ms(report.unattributed());
+	out += ",\n  \"phases\": [";
+	for (std::size_t i = 0; i < report.phases.size(); ++i) {
+		const auto &p = report.phases[i];
+		out += i == 0 ? "\n" : ",\n";
+		out += "    { \"name\": " + quote(p.name) + ", \"start_ms\": " + ms(p.start) +
+			   ", \"duration_ms\": " + ms(p.duration) + " }";
+	}
+	out += "\n  ]\n}\n";
+	return out;
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include "user.hpp"
+#include "user_columns.hpp"
+
+//================================
+// 			STRING HASH
+//================================
+// wyhash-style 64-bit hash: keys up to 16 bytes are two overlapping loads and one 64x64->128 multiply, longer
+// keys fold 48/16 bytes per round. Well distributed in every bit, so it is safe for power-of-two tables.
+namespace string_hash {
+
+inline constexpr std::uint64_t secret[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull,
+											 0x4d5a2da51de1aa47ull };
+inline constexpr std::uint64_t default_seed = 0x9e3779b97f4a7c15ull;
+
+inline void mum(std::uint64_t &a, std::uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+	a = static_cast<std::uint64_t>(r);
+	b = static_cast<std::uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	a = _umul128(a, b, &b);
+#else
+	// portable 64x64->128 through four 32-bit products
+	const std::uint64_t ha = a >> 32, hb = b >> 32;
+	const std::uint64_t la = static_cast<std::uint32_t>(a), lb = static_cast<std::uint32_t>(b);
+	const std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const std::uint64_t t = rl + (rm0 << 32);
+	std::uint64_t c = t < rl;
+	const std::uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	a = lo;
+#endif
+}
+
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+	mum(a, b);
+	return a ^ b;
+}
+
+inline std::uint64_t read8(const char *p) {
+	std::uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+}
+
+inline std::uint64_t read4(const char *p) {
+	std::uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+}
+
+inline std::uint64_t read3(const char *p, std::size_t k) {
+	return static_cast<std::uint64_t>(static_cast<unsigned char>(p[0])) << 16 |
+		   static_cast<std::uint64_t>(static_cast<unsigned char>(p[k >> 1])) << 8 |
+		   static_cast<unsigned char>(p[k - 1]);
+}
+
+// The two words a key of at most 16 bytes is hashed from.
+inline void read_short(const char *p, std::size_t len, std::uint64_t &a, std::uint64_t &b) {
+	if (len >= 4) {
+		const std::size_t shift = (len >> 3) << 2;
+		a = read4(p) << 32 | read4(p + shift);
+		b = read4(p + len - 4) << 32 | read4(p + len - 4 - shift);
+	}
+	else if (len > 0) {
+		a = read3(p, len);
+		b = 0;
+	}
+	else {
+		a = b = 0;
+	}
+}
+
+inline std::uint64_t start(std::uint64_t seed) {
+	return seed ^ mix(seed ^ secret[0], secret[1]);
+}
+
+inline std::uint64_t finish(std::uint64_t a, std::uint64_t b, std::uint64_t seed, std::size_t len) {
+	a ^= secret[1];
+	b ^= seed;
+	mum(a, b);
+	return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+inline std::uint64_t hash(std::string_view key, std::uint64_t seed = default_seed) {
+	const char *p = key.data();
+	const std::size_t len = key.size();
+	seed = start(seed);
+	std::uint64_t a, b;
+	if (len <= 16) {
+		read_short(p, len, a, b);
+	}
+	else {
+		std::size_t i = len;
+		if (i > 48) {
+			std::uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+				see1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ see1);
+				see2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = read8(p + i - 16);
+		b = read8(p + i - 8);
+	}
+	return finish(a, b, seed, len);
+}
+
+// Folds another 64-bit value into a running hash (for multi-field keys).
+inline std::uint64_t combine(std::uint64_t h, std::uint64_t v) {
+	return mix(h ^ secret[2], v ^ secret[3]);
+}
+
+// Hashes many keys. Four keys at a time go through the short-key path side by side, so their multiplies are
+// independent and overlap in the pipeline; the 64x64->128 multiply has no vector equivalent, so this beats a
+// SIMD port of the same mixer. A group holding a key longer than 16 bytes is hashed one key at a time.
+inline void hash_batch(std::span<const std::string_view> keys, std::span<std::uint64_t> out,
+					   std::uint64_t seed = default_seed) {
+	const std::uint64_t seeded = start(seed);
+	std::size_t i = 0;
+	for (; i + 4 <= keys.size(); i += 4) {
+		const std::string_view *k = keys.data() + i;
+		if (std::max({ k[0].size(), k[1].size(), k[2].size(), k[3].size() }) > 16) {
+			for (std::size_t lane = 0; lane < 4; ++lane) {
+				out[i + lane] = hash(k[lane], seed);
+			}
+			continue;
+		}
+		std::uint64_t a[4], b[4];
+		for (std::size_t lane = 0; lane < 4; ++lane) {
+			read_short(k[lane].data(), k[lane].size(), a[lane], b[lane]);
+		}
+		for (std::size_t lane = 0; lane < 4; ++lane) {
+			out[i + lane] = finish(a[lane], b[lane], seeded, k[lane].size());
+		}
+	}
+	for (; i < keys.size(); ++i) {
+		out[i] = hash(keys[i], seed);
+	}
+}
+
+// Hashes every row of an Arrow utf8 column straight from its offsets/data buffers. Null rows hash as "".
+inline void hash_column(const StringColumnView &column, std::span<std::uint64_t> out,
+						std::uint64_t seed = default_seed) {
+	constexpr std::size_t lanes = 64;
+	std::string_view keys[lanes];
+	for (std::size_t base = 0; base < column.size(); base += lanes) {
+		const std::size_t n = std::min(lanes, column.size() - base);
+		for (std::size_t k = 0; k < n; ++k) {
+			keys[k] = column[base + k];
+		}
+		hash_batch(std::span(keys, n), out.subspan(base, n), seed);
+	}
+}
+
+} // namespace string_hash
+
+// Transparent hasher: std::string, std::string_view and const char* keys share one hash, so lookups by view
+// don't allocate.
+struct StringHash {
+	using is_transparent = void;
+
+	std::size_t operator()(std::string_view s) const {
+		return static_cast<std::size_t>(string_hash::hash(s));
+	}
+};
+
+// Hash of a whole UserTypeConcept record (username then email).
+struct UserHash {
+	template<UserTypeConcept T>
+	std::size_t operator()(const T &user) const {
+		const auto h = string_hash::hash(user_columns_detail::as_string_view(user.username));
+		return static_cast<std::size_t>(
+			string_hash::combine(h, string_hash::hash(user_columns_detail::as_string_view(user.email))));
+	}
+};
+
+// Default containers for username/email keyed indexes, and for indexes keyed by whole user records.
+template<typename V>
+using StringKeyMap = std::unordered_map<std::string, V, StringHash, std::equal_to<>>;
+using StringKeySet = std::unordered_set<std::string, StringHash, std::equal_to<>>;
+template<UserTypeConcept T, typename V>
+using UserKeyMap = std::unordered_map<T, V, UserHash>;
+template<UserTypeConcept T = User>
+using UserKeySet = std::unordered_set<T, UserHash>;
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "vec3.hpp"
+
+//================================
+// 			SUMMATION
+//================================
+// Accurate float/double sums at close to naive speed. Both methods keep `lanes` independent partial sums, three
+// 32-byte vectors' worth, so the adds vectorize without reassociating anything. Because the lane count is a
+// multiple of 3, lane k of a Vec3 array (viewed as packed floats) always holds component k % 3.
+// - pairwise: lanes accumulate blocks of pairwise_block elements; blocks are combined as a balanced tree. The
+//   error grows like log(n) instead of n, which is enough for float centroids of large scenes.
+// - Neumaier: every lane also carries a running compensation, and blocks merge through the same compensated
+//   step, so the error stays at a few ulps however large n is or however much values cancel. It runs a few
+//   times slower than pairwise, still ahead of a naive loop, whose adds wait on each other.
+namespace summation_detail {
+
+template<typename T>
+concept SummandConcept = std::same_as<T, float> || std::same_as<T, double>;
+
+template<SummandConcept T>
+inline constexpr std::size_t lanes = 96 / sizeof(T); // 24 floats / 12 doubles
+
+inline constexpr std::size_t pairwise_block = 4096;
+
+// acc[k] += x[i] for every i = k (mod lanes); x must start on a lane boundary of the whole input.
+template<SummandConcept T>
+void accumulate_lanes(const T *x, std::size_t n, T *acc) {
+	constexpr std::size_t L = lanes<T>;
+	std::size_t i = 0;
+#if defined(__AVX__)
+	if constexpr (std::same_as<T, float>) {
+		__m256 a0 = _mm256_loadu_ps(acc), a1 = _mm256_loadu_ps(acc + 8), a2 = _mm256_loadu_ps(acc + 16);
+		for (; i + L <= n; i += L) {
+			a0 = _mm256_add_ps(a0, _mm256_loadu_ps(x + i));
+			a1 = _mm256_add_ps(a1, _mm256_loadu_ps(x + i + 8));
+			a2 = _mm256_add_ps(a2, _mm256_loadu_ps(x + i + 16));
+		}
+		_mm256_storeu_ps(acc, a0);
+		_mm256_storeu_ps(acc + 8, a1);
+		_mm256_storeu_ps(acc + 16, a2);
+	}
+	else {
+		__m256d a0 = _mm256_loadu_pd(acc), a1 = _mm256_loadu_pd(acc + 4), a2 = _mm256_loadu_pd(acc + 8);
+		for (; i + L <= n; i += L) {
+			a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x + i));
+			a1 = _mm256_add_pd(a1, _mm256_loadu_pd(x + i + 4));
+			a2 = _mm256_add_pd(a2, _mm256_loadu_pd(x + i + 8));
+		}
+		_mm256_storeu_pd(acc, a0);
+		_mm256_storeu_pd(acc + 4, a1);
+		_mm256_storeu_pd(acc + 8, a2);
+	}
+#endif
+	for (; i + L <= n; i += L) {
+		for (std::size_t k = 0; k < L; ++k) {
+			acc[k] += x[i + k];
+		}
+	}
+	for (; i < n; ++i) {
+		acc[i % L] += x[i];
+	}
+}
+
+template<SummandConcept T>
+void neumaier_step(T &sum, T &comp, T x) {
+	const T t = sum + x;
+	comp += std::abs(sum) >= std::abs(x) ? (sum - t) + x : (x - t) + sum;
+	sum = t;
+}
+
+// Neumaier sums per lane: sum[k] + comp[k] is the compensated total of the lane.
+template<SummandConcept T>
+void neumaier_lanes(const T *x, std::size_t n, T *sum, T *comp) {
+	constexpr std::size_t L = lanes<T>;
+	std::fill_n(sum, L, T{ 0 });
+	std::fill_n(comp, L, T{ 0 });
+	std::size_t i = 0;
+#if defined(__AVX__)
+	if constexpr (std::same_as<T, float>) {
+		const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		__m256 s[3], c[3];
+		for (int v = 0; v < 3; ++v) {
+			s[v] = c[v] = _mm256_setzero_ps();
+		}
+		for (; i + L <= n; i += L) {
+			for (int v = 0; v < 3; ++v) {
+				const __m256 xv = _mm256_loadu_ps(x + i + 8 * v);
+				const __m256 t = _mm256_add_ps(s[v], xv);
+				const __m256 s_bigger =
+					_mm256_cmp_ps(_mm256_and_ps(s[v], abs_mask), _mm256_and_ps(xv, abs_mask), _CMP_GE_OQ);
+				const __m256 big = _mm256_blendv_ps(xv, s[v], s_bigger), small = _mm256_blendv_ps(s[v], xv, s_bigger);
+				c[v] = _mm256_add_ps(c[v], _mm256_add_ps(_mm256_sub_ps(big, t), small));
+				s[v] = t;
+			}
+		}
+		for (int v = 0; v < 3; ++v) {
+			_mm256_storeu_ps(sum + 8 * v, s[v]);
+			_mm256_storeu_ps(comp + 8 * v, c[v]);
+		}
+	}
+	else {
+		const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffll));
+		__m256d s[3], c[3];
+		for (int v = 0; v < 3; ++v) {
+			s[v] = c[v] = _mm256_setzero_pd();
+		}
+		for (; i + L <= n; i += L) {
+			for (int v = 0; v < 3; ++v) {
+				const __m256d xv = _mm256_loadu_pd(x + i + 4 * v);
+				const __m256d t = _mm256_add_pd(s[v], xv);
+				const __m256d s_bigger =
+					_mm256_cmp_pd(_mm256_and_pd(s[v], abs_mask), _mm256_and_pd(xv, abs_mask), _CMP_GE_OQ);
+				const __m256d big = _mm256_blendv_pd(xv, s[v], s_bigger), small = _mm256_blendv_pd(s[v], xv, s_bigger);
+				c[v] = _mm256_add_pd(c[v], _mm256_add_pd(_mm256_sub_pd(big, t), small));
+				s[v] = t;
+			}
+		}
+		for (int v = 0; v < 3; ++v) {
+			_mm256_storeu_pd(sum + 4 * v, s[v]);
+			_mm256_storeu_pd(comp + 4 * v, c[v]);
+		}
+	}
+#endif
+	for (; i + L <= n; i += L) {
+		for (std::size_t k = 0; k < L; ++k) {
+			neumaier_step(sum[k], comp[k], x[i + k]);
+		}
+	}
+	for (; i < n; ++i) {
+		neumaier_step(sum[i % L], comp[i % L], x[i]);
+	}
+}
+
+// Lane sums of x over a balanced tree of pairwise_block leaves, halves split on lane boundaries. Compensated
+// leaves run Neumaier and the tree merges (sum, comp) pairs with the same step, so no compensation term ever
+// collects more than a block's worth of rounding error; otherwise comp is untouched.
+template<SummandConcept T, bool compensated>
+void tree_lanes(const T *x, std::size_t n, T *sum, T *comp) {
+	constexpr std::size_t L = lanes<T>;
+	if (n <= pairwise_block) {
+		if constexpr (compensated) {
+			neumaier_lanes(x, n, sum, comp);
+		}
+		else {
+			std::fill_n(sum, L, T{ 0 });
+			accumulate_lanes(x, n, sum);
+		}
+		return;
+	}
+	const std::size_t mid = n / 2 / L * L;
+	T right_sum[L], right_comp[L];
+	tree_lanes<T, compensated>(x, mid, sum, comp);
+	tree_lanes<T, compensated>(x + mid, n - mid, right_sum, right_comp);
+	for (std::size_t k = 0; k < L; ++k) {
+		if constexpr (compensated) {
+			neumaier_step(sum[k], comp[k], right_sum[k]);
+			comp[k] += right_comp[k];
+		}
+		else {
+			sum[k] += right_sum[k];
+		}
+	}
+}
+
+// out[c] = total of lanes c, c + period, ... (compensated), for c < period.
+template<SummandConcept T>
+void fold_lanes(const T *sum, const T *comp, std::size_t period, T *out) {
+	for (std::size_t c = 0; c < period; ++c) {
+		T s = 0, k = 0;
+		for (std::size_t l = c; l < lanes<T>; l += period) {
+			neumaier_step(s, k, sum[l]);
+			k += comp != nullptr ? comp[l] : T{ 0 };
+		}
+		out[c] = s + k;
+	}
+}
+
+template<SummandConcept T>
+void pairwise_sum(const T *x, std::size_t n, std::size_t period, T *out) {
+	T sum[lanes<T>];
+	tree_lanes<T, false>(x, n, sum, nullptr);
+	fold_lanes<T>(sum, nullptr, period, out);
+}
+
+template<SummandConcept T>
+void neumaier_sum(const T *x, std::size_t n, std::size_t period, T *out) {
+	T sum[lanes<T>], comp[lanes<T>];
+	tree_lanes<T, true>(x, n, sum, comp);
+	fold_lanes<T>(sum, comp, period, out);
+}
+
+// Vec3 arrays are three packed floats per point (asserted in vec3.hpp), so they are summed as one float array.
+inline const float *as_floats(std::span<const Vec3> points) {
+	return reinterpret_cast<const float *>(points.data());
+}
+
+} // namespace summation_detail
+
+inline float pairwise_sum(std::span<const float> x) {
+	float out;
+	summation_detail::pairwise_sum(x.data(), x.size(), 1, &out);
+	return out;
+}
+
+inline double pairwise_sum(std::span<const double> x) {
+	double out;
+	summation_detail::pairwise_sum(x.data(), x.size(), 1, &out);
+	return out;
+}
+
+inline Vec3 pairwise_sum(std::span<const Vec3> points) {
+	float out[3];
+	summation_detail::pairwise_sum(summation_detail::as_floats(points), 3 * points.size(), 3, out);
+	return { out[0], out[1], out[2] };
+}
+
+inline float neumaier_sum(std::span<const float> x) {
+	float out;
+	summation_detail::neumaier_sum(x.data(), x.size(), 1, &out);
+	return out;
+}
+
+inline double neumaier_sum(std::span<const double> x) {
+	double out;
+	summation_detail::neumaier_sum(x.data(), x.size(), 1, &out);
+	return out;
+}
+
+inline Vec3 neumaier_sum(std::span<const Vec3> points) {
+	float out[3];
+	summation_detail::neumaier_sum(summation_detail::as_floats(points), 3 * points.size(), 3, out);
+	return { out[0], out[1], out[2] };
+}
+
+// Mean of the points, summed pairwise in float; (0, 0, 0) for an empty span.
+inline Vec3 centroid(std::span<const Vec3> points) {
+	if (points.empty()) {
+		return { 0, 0, 0 };
+	}
+	const Vec3 s = pairwise_sum(points);
+	const float inv = 1.0f / static_cast<float>(points.size());
+	return { s.e0 * inv, s.e1 * inv, s.e2 * inv };
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <print>
+#include <random>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define TEST_REGISTRY_HAS_FORK 1
+#endif
+
+#include "parallel.hpp"
+
+//================================
+// 			EXPECT
+//================================
+// assert() is compiled out with NDEBUG; expect() is not. A failed expectation throws, which fails only the test
+// that raised it.
+struct TestFailure : std::runtime_error {
+	using std::runtime_error::runtime_error;
+};
+
+inline void expect(bool condition, std::source_location where = std::source_location::current()) {
+	if (!condition) {
+		throw TestFailure(std::string(where.file_name()) + ":" + std::to_string(where.line()) +
+						  ": expectation failed in " + where.function_name());
+	}
+}
+
+//================================
+// 			SCRATCH DIR
+//================================
+// A fresh directory under temp_directory_path() for a test's files, removed with its contents when the ScratchDir
+// goes out of scope. The name carries the pid and a per-process counter, so tests running at the same time, in
+// this process or in another build tree's, never write to the same file.
+class ScratchDir {
+public:
+	explicit ScratchDir(std::string_view prefix) {
+		static std::atomic<unsigned> counter{ 0 };
+#if defined(TEST_REGISTRY_HAS_FORK)
+		const auto pid = static_cast<long>(::getpid());
+#else
+		const auto pid = static_cast<long>(std::random_device{}());
+#endif
+		do {
+			path_ = std::filesystem::temp_directory_path() /
+					(std::string(prefix) + "-" + std::to_string(pid) + "-" + std::to_string(counter++));
+		} while (!std::filesystem::create_directory(path_));
+	}
+
+	~ScratchDir() {
+		std::error_code ec;
+		std::filesystem::remove_all(path_, ec);
+	}
+
+	ScratchDir(const ScratchDir &) = delete;
+	ScratchDir &operator=(const ScratchDir &) = delete;
+
+	const std::filesystem::path &path() const {
+		return path_;
+	}
+
+	std::filesystem::path operator/(std::string_view name) const {
+		return path_ / name;
+	}
+
+private:
+	std::filesystem::path path_;
+};
+
+//================================
+// 			TEST REGISTRY
+//================================
+// Anything callable with a name can be registered: a plain function, a lambda, or a type that carries its own
+// name. Tests run in parallel; on POSIX every test gets a forked process, so a crash or abort fails one test and
+// each test's output is captured and printed as one block. Elsewhere (or with --threads) they share the pool.
+//
+//     registry --list                          names, one per line
+//     registry [--jobs N] [--threads] [name...]  run all or the named tests
+//     registry --ctest-file out.cmake exe      write one add_test() per test, for CTest discovery
+template<typename T>
+concept NamedTestConcept = std::invocable<T &> && requires(const T &t) {
+	{ t.name } -> std::convertible_to<std::string_view>;
+};
+
+class TestRegistry {
+public:
+	struct Result {
+		std::string name;
+		bool passed{};
+		std::chrono::duration<double, std::milli> elapsed{};
+		std::string output; // captured stdout/stderr (process mode) or the failure message
+	};
+
+	template<std::invocable F>
+	TestRegistry &add(std::string name, F fn) {
+		tests_.push_back({ std::move(name), std::function<void()>(std::move(fn)) });
+		return *this;
+	}
+
+	template<NamedTestConcept T>
+	TestRegistry &add(T test) {
+		std::string name(std::string_view(test.name));
+		return add(std::move(name), [test = std::move(test)]() mutable { test(); });
+	}
+
+	std::size_t size() const {
+		return tests_.size();
+	}
+
+	// Runs the selected tests; prints each test's output as it finishes and a timing summary at the end.
+	std::vector<Result> run(const std::vector<std::string> &names, std::size_t jobs, bool use_threads) {
+		std::vector<std::size_t> selected;
+		for (std::size_t i = 0; i < tests_.size(); ++i) {
+			if (names.empty() || std::ranges::find(names, tests_[i].name) != names.end()) {
+				selected.push_back(i);
+			}
+		}
+		for (const auto &name : names) {
+			if (std::ranges::none_of(tests_, [&](const Entry &e) { return e.name == name; })) {
+				throw std::invalid_argument("no test named '" + name + "'");
+			}
+		}
+
+		jobs = jobs == 0 ? std::max(1u, std::thread::hardware_concurrency()) : jobs;
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<Result> results;
+		if (jobs == 1 || selected.size() == 1) {
+			// in-process and in order: what CTest runs per test, and what a debugger wants
+			for (auto i : selected) {
+				std::println("-------- {} --------", tests_[i].name);
+				std::fflush(stdout);
+				results.push_back(run_here(tests_[i]));
+				report(results.back(), false);
+			}
+		}
+#if defined(TEST_REGISTRY_HAS_FORK)
+		else if (!use_threads) {
+			results = run_forked(selected, jobs);
+		}
+#endif
+		else {
+			results = run_threaded(selected, jobs);
+		}
+		summarize(results, std::chrono::steady_clock::now() - start);
+		return results;
+	}
+
+	// Command-line front end for main(); returns the process exit code.
+	int main(int argc, char **argv) {
+		std::vector<std::string> names;
+		std::size_t jobs = 0;
+		bool use_threads = false;
+		try {
+			for (int i = 1; i < argc; ++i) {
+				const std::string_view arg = argv[i];
+				if (arg == "--list") {
+					for (const auto &t : tests_) {
+						std::println("{}", t.name);
+					}
+					return 0;
+				}
+				else if (arg == "--ctest-file" && i + 2 < argc) {
+					write_ctest_file(argv[i + 1], argv[i + 2]);
+					return 0;
+				}
+				else if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+					jobs = static_cast<std::size_t>(std::stoul(argv[++i]));
+				}
+				else if (arg == "--threads") {
+					use_threads = true;
+				}
+				else if (arg.starts_with("-")) {
+					throw std::invalid_argument("unknown option " + std::string(arg));
+				}
+				else {
+					names.emplace_back(arg);
+				}
+			}
+			const auto results = run(names, jobs, use_threads);
+			return std::ranges::all_of(results, &Result::passed) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		catch (const std::exception &e) {
+			std::println(stderr, "{}", e.what());
+			return 2;
+		}
+	}
+
+private:
+	struct Entry {
+		std::string name;
+		std::function<void()> fn;
+	};
+
+	static Result run_here(const Entry &test) {
+		Result result;
+		result.name = test.name;
+		const auto start = std::chrono::steady_clock::now();
+		try {
+			test.fn();
+			result.passed = true;
+		}
+		catch (const std::exception &e) {
+			result.output = e.what();
+		}
+		catch (...) {
+			result.output = "unknown exception";
+		}
+		result.elapsed = std::chrono::steady_clock::now() - start;
+		return result;
+	}
+
+	std::vector<Result> run_threaded(const std::vector<std::size_t> &selected, std::size_t jobs) {
+		// output is not captured here, so it interleaves; results are reported once everything is done
+		std::vector<Result> results(selected.size());
+		ThreadPool pool(jobs);
+		parallel_for(selected.size(), 1, [&](std::size_t b, std::size_t e) {
+			for (std::size_t k = b; k < e; ++k) {
+				results[k] = run_here(tests_[selected[k]]);
+			}
+		}, pool);
+		for (const auto &r : results) {
+			report(r, false);
+		}
+		return results;
+	}
+
+#if defined(TEST_REGISTRY_HAS_FORK)
+	std::vector<Result> run_forked(const std::vector<std::size_t> &selected, std::size_t jobs) {
+		struct Child {
+			pid_t pid;
+			int fd;
+			Result result;
+			std::chrono::steady_clock::time_point start;
+		};
+		std::vector<Result> results;
+		std::vector<Child> running;
+		std::size_t next = 0;
+		std::cout.flush();
+		std::fflush(nullptr); // or the children would inherit and re-print our buffered output
+
+		while (next < selected.size() || !running.empty()) {
+			while (running.size() < jobs && next < selected.size()) {
+				const Entry &test = tests_[selected[next++]];
+				int pipe_fds[2];
+				if (::pipe(pipe_fds) != 0) {
+					throw std::system_error(errno, std::generic_category(), "pipe");
+				}
+				const pid_t pid = ::fork();
+				if (pid < 0) {
+					throw std::system_error(errno, std::generic_category(), "fork");
+				}
+				if (pid == 0) {
+					::dup2(pipe_fds[1], STDOUT_FILENO);
+					::dup2(pipe_fds[1], STDERR_FILENO);
+					::close(pipe_fds[0]);
+					::close(pipe_fds[1]);
+					std::setvbuf(stdout, nullptr, _IOLBF, 0); // keep what was printed before a crash
+					const Result r = run_here(test);
+					if (!r.passed) {
+						std::println(stderr, "{}", r.output);
+					}
+					std::cout.flush();
+					std::fflush(nullptr);
+					std::_Exit(r.passed ? 0 : 1);
+				}
+				::close(pipe_fds[1]);
+				running.push_back({ pid, pipe_fds[0], {}, std::chrono::steady_clock::now() });
+				running.back().result.name = test.name;
+			}
+
+			std::vector<pollfd> fds;
+			for (const auto &c : running) {
+				fds.push_back({ c.fd, POLLIN, 0 });
+			}
+			if (::poll(fds.data(), fds.size(), -1) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::system_error(errno, std::generic_category(), "poll");
+			}
+			for (std::size_t k = fds.size(); k-- > 0;) {
+				if (fds[k].revents == 0) {
+					continue;
+				}
+				Child &c = running[k];
+				char buf[4096];
+				const auto n = ::read(c.fd, buf, sizeof(buf));
+				if (n > 0) {
+					c.result.output.append(buf, static_cast<std::size_t>(n));
+					continue;
+				}
+				if (n < 0 && errno == EINTR) {
+					continue;
+				}
+				// EOF: the child is exiting
+				::close(c.fd);
+				int status = 0;
+				while (::waitpid(c.pid, &status, 0) < 0 && errno == EINTR) {
+				}
+				c.result.elapsed = std::chrono::steady_clock::now() - c.start;
+				c.result.passed = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+				if (WIFSIGNALED(status)) {
+					c.result.output += "terminated by signal " + std::to_string(WTERMSIG(status)) + "\n";
+				}
+				report(c.result, true);
+				results.push_back(std::move(c.result));
+				running.erase(running.begin() + static_cast<std::ptrdiff_t>(k));
+			}
+		}
+		return results;
+	}
+#endif
+
+	static void report(const Result &r, bool with_output) {
+		if (with_output) {
+			std::println("-------- {} --------", r.name);
+			std::print("{}", r.output);
+		}
+		else if (!r.passed) {
+			std::println("{}", r.output);
+		}
+		std::println("[{}] {} ({:.1f} ms)", r.passed ? "  ok  " : " FAIL ", r.name, r.elapsed.count());
+		std::fflush(stdout);
+	}
+
+	static void summarize(std::vector<Result> results, std::chrono::duration<double, std::milli> wall) {
+		std::ranges::sort(results, std::greater{}, [](const Result &r) { return r.elapsed; });
+		double total = 0;
+		std::size_t failed = 0;
+		for (const auto &r : results) {
+			total += r.elapsed.count();
+			failed += r.passed ? 0 : 1;
+		}
+		std::println("======== {} tests, {} failed, {:.1f} ms wall, {:.1f} ms summed ========", results.size(), failed,
+					 wall.count(), total);
+		for (std::size_t i = 0; i < std::min<std::size_t>(results.size(), 5); ++i) {
+			std::println("  slowest: {} ({:.1f} ms)", results[i].name, results[i].elapsed.count());
+		}
+	}
+
+	// One CTest entry per registered test, each running that test alone. Loaded through TEST_INCLUDE_FILES.
+	void write_ctest_file(const std::string &path, const std::string &executable) const {
+		std::ofstream out(path);
+		for (const auto &t : tests_) {
+			out << "add_test([==[" << t.name << "]==] [==[" << executable << "]==] [==[" << t.name << "]==])\n";
+		}
+		if (!out) {
+			throw std::runtime_error("cannot write " + path);
+		}
+	}
+
+	std::vector<Entry> tests_;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <concepts>
+#include <string>
+#include <utility>
+
+struct User {
+	std::string username;
+	std::string email;
+
+	friend bool operator==(const User &, const User &) = default;
+};
+
+template<typename T>
+concept UserTypeConcept = 
+	requires(T t) {
+		{ t.username } -> std::convertible_to<std::string>;
+		/*
+			- requires is the definition / identity of the constraint that concept will use
+			- bagian kiri bisa dibaca: { t.username } results in std::string&, which is a reference to User::username
+			- bagian kanan bisa dibaca: std::convertible_to<std::string&, std::string>;
+		*/
+	} && requires {
+		{ std::declval<T>().email } -> std::convertible_to<std::string>;
+	};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "user.hpp"
+
+//================================
+// 			STRING COLUMNS
+//================================
+// Arrow utf8 layout: an optional validity bitmap (LSB first, 1 = present), n + 1 int32 offsets and one
+// contiguous UTF-8 data buffer. Value i is data[offsets[i] .. offsets[i + 1]).
+
+// Non-owning view; used both for in-memory columns and for columns mapped straight out of an Arrow file.
+struct StringColumnView {
+	const std::uint8_t *validity{}; // null when the column has no nulls
+	const std::int32_t *offsets{};
+	const char *data{};
+	std::size_t length{};
+	std::size_t null_count{};
+
+	std::size_t size() const {
+		return length;
+	}
+
+	bool is_valid(std::size_t i) const {
+		return validity == nullptr || (validity[i / 8] >> (i % 8) & 1) != 0;
+	}
+
+	// Null entries read as "".
+	std::string_view operator[](std::size_t i) const {
+		return { data + offsets[i], static_cast<std::size_t>(offsets[i + 1] - offsets[i]) };
+	}
+
+	std::size_t data_bytes() const {
+		return length == 0 ? 0 : static_cast<std::size_t>(offsets[length]);
+	}
+};
+
+// Owning builder for one utf8 column.
+class StringColumn {
+public:
+	StringColumn() : offsets_{ 0 } {}
+
+	void reserve(std::size_t rows, std::size_t bytes) {
+		offsets_.reserve(rows + 1);
+		data_.reserve(bytes);
+	}
+
+	void append(std::string_view value) {
+		if (data_.size() + value.size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+			throw std::length_error("utf8 column exceeds 2 GiB; split it into several batches");
+		}
+		data_.append(value);
+		offsets_.push_back(static_cast<std::int32_t>(data_.size()));
+		if (!validity_.empty()) {
+			set_valid(size() - 1, true);
+		}
+	}
+
+	void append_null() {
+		if (validity_.empty()) {
+			// first null: materialize the bitmap for everything appended so far
+			validity_.assign((size() + 8) / 8, 0xff);
+		}
+		offsets_.push_back(offsets_.back());
+		set_valid(size() - 1, false);
+		++null_count_;
+	}
+
+	std::size_t size() const {
+		return offsets_.size() - 1;
+	}
+
+	StringColumnView view() const {
+		return { validity_.empty() ? nullptr : validity_.data(), offsets_.data(), data_.data(), size(), null_count_ };
+	}
+
+private:
+	void set_valid(std::size_t i, bool valid) {
+		if (validity_.size() <= i / 8) {
+			validity_.resize(i / 8 + 1, 0);
+		}
+		if (valid) {
+			validity_[i / 8] |= static_cast<std::uint8_t>(1u << (i % 8));
+		}
+		else {
+			validity_[i / 8] &= static_cast<std::uint8_t>(~(1u << (i % 8)));
+		}
+	}
+
+	std::vector<std::uint8_t> validity_;
+	std::vector<std::int32_t> offsets_;
+	std::string data_;
+	std::size_t null_count_{};
+};
+
+//================================
+// 			USER COLUMNS
+//================================
+struct UserColumnsView {
+	StringColumnView username;
+	StringColumnView email;
+
+	std::size_t size() const {
+		return username.size();
+	}
+};
+
+namespace user_columns_detail {
+
+// Reads a UserTypeConcept field without copying when it already is (or views as) a string.
+template<typename Field>
+decltype(auto) as_string_view(const Field &field) {
+	if constexpr (std::convertible_to<const Field &, std::string_view>) {
+		return std::string_view(field);
+	}
+	else {
+		return std::string(field);
+	}
+}
+
+} // namespace user_columns_detail
+
+// Columnar copy of a collection of UserTypeConcept records.
+class UserColumns {
+public:
+	template<std::ranges::input_range R>
+		requires UserTypeConcept<std::ranges::range_value_t<R>>
+	static UserColumns from(R &&users) {
+		UserColumns columns;
+		if constexpr (std::ranges::sized_range<R>) {
+			columns.username_.reserve(std::ranges::size(users), 0);
+			columns.email_.reserve(std::ranges::size(users), 0);
+		}
+		for (const auto &user : users) {
+			columns.append(user);
+		}
+		return columns;
+	}
+
+	template<UserTypeConcept T>
+	void append(const T &user) {
+		username_.append(user_columns_detail::as_string_view(user.username));
+		email_.append(user_columns_detail::as_string_view(user.email));
+	}
+
+	StringColumn &username() {
+		return username_;
+	}
+
+	StringColumn &email() {
+		return email_;
+	}
+
+	std::size_t size() const {
+		return username_.size();
+	}
+
+	UserColumnsView view() const {
+		assert(username_.size() == email_.size());
+		return { username_.view(), email_.view() };
+	}
+
+private:
+	StringColumn username_;
+	StringColumn email_;
+};
+
+// Materializes row i back into any UserTypeConcept record that has assignable username/email members.
+template<UserTypeConcept T = User>
+T user_at(const UserColumnsView &columns, std::size_t i) {
+	T user{};
+	user.username = std::string(columns.username[i]);
+	user.email = std::string(columns.email[i]);
+	return user;
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "string_hash.hpp"
+#include "user_columns.hpp"
+
+//================================
+// 			SELECTION BITMAP
+//================================
+// One bit per row, 64 rows per word; bits past size() are always zero.
+class SelectionBitmap {
+public:
+	SelectionBitmap() = default;
+
+	explicit SelectionBitmap(std::size_t rows, bool value = false)
+		: words_((rows + 63) / 64, value ? ~0ull : 0), rows_(rows) {
+		clear_tail();
+	}
+
+	std::size_t size() const {
+		return rows_;
+	}
+
+	bool test(std::size_t i) const {
+		return (words_[i / 64] >> (i % 64) & 1) != 0;
+	}
+
+	void set(std::size_t i) {
+		words_[i / 64] |= 1ull << (i % 64);
+	}
+
+	std::size_t count() const {
+		std::size_t n = 0;
+		for (auto w : words_) {
+			n += static_cast<std::size_t>(std::popcount(w));
+		}
+		return n;
+	}
+
+	// Calls fn(row) for every selected row, in order.
+	template<typename F>
+	void for_each(F &&fn) const {
+		for (std::size_t w = 0; w < words_.size(); ++w) {
+			for (auto bits = words_[w]; bits != 0; bits &= bits - 1) {
+				fn(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+			}
+		}
+	}
+
+	// Selected rows as a sorted id list, the form sorted_intersection() and friends take.
+	std::vector<std::uint32_t> rows() const {
+		std::vector<std::uint32_t> out;
+		out.reserve(count());
+		for_each([&](std::size_t i) { out.push_back(static_cast<std::uint32_t>(i)); });
+		return out;
+	}
+
+	std::span<std::uint64_t> words() {
+		return words_;
+	}
+
+	std::span<const std::uint64_t> words() const {
+		return words_;
+	}
+
+	void clear_tail() {
+		if (rows_ % 64 != 0 && !words_.empty()) {
+			words_.back() &= (1ull << (rows_ % 64)) - 1;
+		}
+	}
+
+private:
+	std::vector<std::uint64_t> words_;
+	std::size_t rows_{};
+};
+
+//================================
+// 			USER QUERY
+//================================
+// Filters over UserColumnsView that never build User objects. A predicate is evaluated 64 rows at a time
+// against a candidate mask: rows already ruled out are never touched, and an all-zero mask word skips its
+// 64 rows outright. `a && b` evaluates b only on rows a selected, `a || b` only on rows a rejected, so a
+// selective first term makes the rest of the expression nearly free.
+//
+//     using namespace user_query;
+//     auto admins = email.domain_in({ "corp.example" }) && !username.starts_with("svc-");
+//     SelectionBitmap hits = filter(columns, admins);
+namespace user_query {
+
+enum class Column { username, email };
+
+inline const StringColumnView &column_of(const UserColumnsView &v, Column c) {
+	return c == Column::username ? v.username : v.email;
+}
+
+// filter() evaluates predicates this many bitmap words (16K rows) at a time, so combinators can keep their
+// scratch words on the stack.
+inline constexpr std::size_t chunk_words = 256;
+
+// Anything with eval(columns, first, n, mask, out): for words first .. first + n, out[k] = rows of mask[k] that
+// match. mask and out point at word `first` and may be the same array; n is at most chunk_words.
+template<typename P>
+concept UserPredicateConcept = requires(const P &p, const UserColumnsView &v, std::size_t w, const std::uint64_t *mask,
+										 std::uint64_t *out) {
+	{ p.eval(v, w, w, mask, out) } -> std::same_as<void>;
+};
+
+// Row test over one string column; nulls never match.
+template<std::predicate<std::string_view> Test>
+struct Leaf {
+	Column column;
+	Test test;
+
+	void eval(const UserColumnsView &v, std::size_t first, std::size_t n, const std::uint64_t *mask,
+			  std::uint64_t *out) const {
+		const StringColumnView &col = column_of(v, column);
+		for (std::size_t k = 0; k < n; ++k) {
+			std::uint64_t hits = 0;
+			for (auto bits = mask[k]; bits != 0; bits &= bits - 1) {
+				const auto bit = std::countr_zero(bits);
+				const std::size_t row = (first + k) * 64 + static_cast<std::size_t>(bit);
+				if (col.is_valid(row) && test(col[row])) {
+					hits |= 1ull << bit;
+				}
+			}
+			out[k] = hits;
+		}
+	}
+};
+
+template<UserPredicateConcept L, UserPredicateConcept R>
+struct And {
+	L lhs;
+	R rhs;
+
+	void eval(const UserColumnsView &v, std::size_t first, std::size_t n, const std::uint64_t *mask,
+			  std::uint64_t *out) const {
+		lhs.eval(v, first, n, mask, out);
+		rhs.eval(v, first, n, out, out); // rhs only sees rows lhs kept
+	}
+};
+
+template<UserPredicateConcept L, UserPredicateConcept R>
+struct Or {
+	L lhs;
+	R rhs;
+
+	void eval(const UserColumnsView &v, std::size_t first, std::size_t n, const std::uint64_t *mask,
+			  std::uint64_t *out) const {
+		assert(n <= chunk_words);
+		std::uint64_t rest[chunk_words]{};
+		std::copy_n(mask, n, rest); // copy first: out may alias mask
+		lhs.eval(v, first, n, rest, out);
+		for (std::size_t k = 0; k < n; ++k) {
+			rest[k] &= ~out[k];
+		}
+		rhs.eval(v, first, n, rest, rest); // rhs only sees rows lhs rejected
+		for (std::size_t k = 0; k < n; ++k) {
+			out[k] |= rest[k];
+		}
+	}
+};
+
+template<UserPredicateConcept P>
+struct Not {
+	P inner;
+
+	void eval(const UserColumnsView &v, std::size_t first, std::size_t n, const std::uint64_t *mask,
+			  std::uint64_t *out) const {
+		assert(n <= chunk_words);
+		std::uint64_t candidates[chunk_words]{};
+		std::copy_n(mask, n, candidates);
+		inner.eval(v, first, n, candidates, out);
+		for (std::size_t k = 0; k < n; ++k) {
+			out[k] = candidates[k] & ~out[k];
+		}
+	}
+};
+
+template<UserPredicateConcept L, UserPredicateConcept R>
+And<L, R> operator&&(L lhs, R rhs) {
+	return { std::move(lhs), std::move(rhs) };
+}
+
+template<UserPredicateConcept L, UserPredicateConcept R>
+Or<L, R> operator||(L lhs, R rhs) {
+	return { std::move(lhs), std::move(rhs) };
+}
+
+template<UserPredicateConcept P>
+Not<P> operator!(P inner) {
+	return { std::move(inner) };
+}
+
+// Builds leaves for one column: username.equals("ada"), email.domain_in({ ... }), username.matches(lambda), ...
+struct ColumnRef {
+	Column column;
+
+	auto equals(std::string value) const {
+		return Leaf { column, [value = std::move(value)](std::string_view s) {
+						 return s.size() == value.size() && std::memcmp(s.data(), value.data(), s.size()) == 0;
+					 } };
+	}
+
+	auto starts_with(std::string prefix) const {
+		return Leaf { column, [prefix = std::move(prefix)](std::string_view s) { return s.starts_with(prefix); } };
+	}
+
+	auto ends_with(std::string suffix) const {
+		return Leaf { column, [suffix = std::move(suffix)](std::string_view s) { return s.ends_with(suffix); } };
+	}
+
+	auto contains(std::string needle) const {
+		return Leaf { column, [needle = std::move(needle)](std::string_view s) {
+						 return s.find(needle) != std::string_view::npos;
+					 } };
+	}
+
+	// Matches values whose part after the last '@' is one of `domains` (exact, case-sensitive).
+	auto domain_in(std::vector<std::string> domains) const {
+		struct DomainSet {
+			std::vector<std::string> storage;
+			std::unordered_set<std::string_view, StringHash> set;
+		};
+		auto owned = std::make_shared<DomainSet>();
+		owned->storage = std::move(domains);
+		owned->set.insert(owned->storage.begin(), owned->storage.end());
+		return Leaf { column, [owned](std::string_view s) {
+						 auto at = s.rfind('@');
+						 return at != std::string_view::npos && owned->set.contains(s.substr(at + 1));
+					 } };
+	}
+
+	// Any concept-checked row test, e.g. username.matches([](std::string_view s) { return s.size() > 8; }).
+	template<std::predicate<std::string_view> Test>
+	Leaf<Test> matches(Test test) const {
+		return { column, std::move(test) };
+	}
+};
+
+inline constexpr ColumnRef username { Column::username };
+inline constexpr ColumnRef email { Column::email };
+
+// Rows of `columns` matching `predicate`. Large tables are split into word ranges across the thread pool.
+template<UserPredicateConcept P>
+SelectionBitmap filter(const UserColumnsView &columns, const P &predicate) {
+	SelectionBitmap all(columns.size(), true);
+	SelectionBitmap out(columns.size());
+	const auto mask = all.words();
+	auto words = out.words();
+	parallel_for(words.size(), 4 * chunk_words, [&](std::size_t first, std::size_t last) {
+		for (std::size_t w = first; w < last; w += chunk_words) {
+			const std::size_t n = std::min(chunk_words, last - w);
+			predicate.eval(columns, w, n, mask.data() + w, words.data() + w);
+		}
+	});
+	return out;
+}
+
+} // namespace user_query
+
+// A set of rows: count() plus for_each(fn) calling fn(row) in row order (SelectionBitmap, RoaringBitmap).
+template<typename S>
+concept SelectionConcept = requires(const S &s) {
+	{ s.count() } -> std::convertible_to<std::size_t>;
+	s.for_each([](std::size_t) {});
+};
+
+// Materializes only the selected rows.
+template<UserTypeConcept T = User, SelectionConcept S>
+std::vector<T> materialize(const UserColumnsView &columns, const S &selection) {
+	std::vector<T> rows;
+	rows.reserve(selection.count());
+	selection.for_each([&](std::size_t i) { rows.push_back(user_at<T>(columns, i)); });
+	return rows;
+}
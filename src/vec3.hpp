@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+struct Vec3 {
+	float e0;
+	float e1;
+	float e2;
+};
+
+// Vec3 is read straight out of mapped files and byte buffers, so its layout must stay three packed floats
+static_assert(std::is_trivially_copyable_v<Vec3> && std::is_standard_layout_v<Vec3>);
+static_assert(sizeof(Vec3) == 3 * sizeof(float) && alignof(Vec3) == alignof(float));
+
+// Axis-aligned bounding box; a default-constructed box is empty and grows with extend().
+struct Aabb {
+	// positional rather than designated initializers: this header is also part of the C++17 firmware build
+	Vec3 lo { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+			  std::numeric_limits<float>::infinity() };
+	Vec3 hi { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+			  -std::numeric_limits<float>::infinity() };
+
+	void extend(const Vec3 p) {
+		lo = { std::min(lo.e0, p.e0), std::min(lo.e1, p.e1), std::min(lo.e2, p.e2) };
+		hi = { std::max(hi.e0, p.e0), std::max(hi.e1, p.e1), std::max(hi.e2, p.e2) };
+	}
+
+	void extend(const Aabb &other) {
+		lo = { std::min(lo.e0, other.lo.e0), std::min(lo.e1, other.lo.e1), std::min(lo.e2, other.lo.e2) };
+		hi = { std::max(hi.e0, other.hi.e0), std::max(hi.e1, other.hi.e1), std::max(hi.e2, other.hi.e2) };
+	}
+
+	bool empty() const {
+		return lo.e0 > hi.e0;
+	}
+};
+
+// Structure-of-arrays counterpart of std::vector<Vec3>.
+struct Vec3SoA {
+	std::vector<float> x, y, z;
+
+	std::size_t size() const {
+		return x.size();
+	}
+
+	void resize(std::size_t n) {
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+	}
+};
+
+// Row-major 3x4 affine transform: rotation/scale in the left 3x3, translation in the last column.
+struct Affine3 {
+	float m[3][4];
+
+	static constexpr Affine3 identity() {
+		return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } };
+	}
+
+	constexpr Vec3 operator()(const Vec3 v) const {
+		return Vec3 {
+			m[0][0] * v.e0 + m[0][1] * v.e1 + m[0][2] * v.e2 + m[0][3],
+			m[1][0] * v.e0 + m[1][1] * v.e1 + m[1][2] * v.e2 + m[1][3],
+			m[2][0] * v.e0 + m[2][1] * v.e1 + m[2][2] * v.e2 + m[2][3],
+		};
+	}
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "vec3.hpp"
+
+// Serial Vec3 kernels with their SIMD paths, kept to C++17 so the parallel C++20 entry points (quaternion.hpp,
+// pairwise_distance.hpp) and the firmware ones (fast_paths_sfinae.hpp) run the same code.
+
+//================================
+// 			BULK TRANSFORM
+//================================
+namespace transform_detail {
+
+// x/y/z are updated in place; the arrays must not overlap each other.
+inline void transform_soa(const Affine3 &a, float *x, float *y, float *z, std::size_t n) {
+	std::size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+	__m256 m[3][4];
+	for (int r = 0; r < 3; ++r) {
+		for (int c = 0; c < 4; ++c) {
+			m[r][c] = _mm256_set1_ps(a.m[r][c]);
+		}
+	}
+	for (; i + 8 <= n; i += 8) {
+		const __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+		__m256 out[3];
+		for (int r = 0; r < 3; ++r) {
+			out[r] = _mm256_fmadd_ps(m[r][0], vx, _mm256_fmadd_ps(m[r][1], vy, _mm256_fmadd_ps(m[r][2], vz, m[r][3])));
+		}
+		_mm256_storeu_ps(x + i, out[0]);
+		_mm256_storeu_ps(y + i, out[1]);
+		_mm256_storeu_ps(z + i, out[2]);
+	}
+#endif
+	for (; i < n; ++i) {
+		const float vx = x[i], vy = y[i], vz = z[i];
+		x[i] = a.m[0][0] * vx + a.m[0][1] * vy + a.m[0][2] * vz + a.m[0][3];
+		y[i] = a.m[1][0] * vx + a.m[1][1] * vy + a.m[1][2] * vz + a.m[1][3];
+		z[i] = a.m[2][0] * vx + a.m[2][1] * vy + a.m[2][2] * vz + a.m[2][3];
+	}
+}
+
+// AoS goes through small SoA staging blocks that stay in L1, so the same vector kernel serves both layouts.
+inline void transform_aos(const Affine3 &a, Vec3 *points, std::size_t n) {
+	constexpr std::size_t block = 256;
+	alignas(32) float x[block], y[block], z[block];
+	for (std::size_t base = 0; base < n; base += block) {
+		const std::size_t count = std::min(block, n - base);
+		for (std::size_t i = 0; i < count; ++i) {
+			x[i] = points[base + i].e0;
+			y[i] = points[base + i].e1;
+			z[i] = points[base + i].e2;
+		}
+		transform_soa(a, x, y, z, count);
+		for (std::size_t i = 0; i < count; ++i) {
+			points[base + i] = { x[i], y[i], z[i] };
+		}
+	}
+}
+
+} // namespace transform_detail
+
+//================================
+// 			PAIRWISE DISTANCE
+//================================
+// GEMM-style blocking for |a_i - b_j|^2: B is repacked tile by tile into SoA so each column block is three
+// vector loads, and a 4-row x 8-column block of results stays in registers while A rows are broadcast.
+// Differences are squared directly (not |a|^2 + |b|^2 - 2ab), so near-zero distances keep their precision.
+namespace distance_detail {
+
+inline constexpr std::size_t tile_cols = 512; // 6 KiB of SoA B per tile, stays in L1
+inline constexpr std::size_t tile_rows = 16;  // A rows per task step; 16 x 512 floats of output scratch
+
+struct SoATile {
+	alignas(32) float x[tile_cols];
+	alignas(32) float y[tile_cols];
+	alignas(32) float z[tile_cols];
+	std::size_t count{};
+
+	void load(const Vec3 *b, std::size_t n) {
+		count = n;
+		for (std::size_t j = 0; j < count; ++j) {
+			x[j] = b[j].e0;
+			y[j] = b[j].e1;
+			z[j] = b[j].e2;
+		}
+	}
+};
+
+// dx^2 + dy^2 + dz^2, rounded like the vector kernel (two fused multiply-adds with FMA) so every element of a
+// distance matrix agrees whichever path computed it.
+inline float sq_norm(float dx, float dy, float dz) {
+#if defined(__AVX2__) && defined(__FMA__)
+	return std::fma(dz, dz, std::fma(dy, dy, dx * dx));
+#else
+	return dx * dx + dy * dy + dz * dz;
+#endif
+}
+
+// out[r * ld + j] = |a[r] - tile[j]|^2 for r < rows, j < tile.count
+inline void tile_kernel(const Vec3 *a, std::size_t rows, const SoATile &t, float *out, std::size_t ld) {
+	std::size_t r = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+	const std::size_t full = t.count / 8 * 8;
+	for (; r + 4 <= rows; r += 4) {
+		__m256 ax[4], ay[4], az[4];
+		for (int k = 0; k < 4; ++k) {
+			ax[k] = _mm256_set1_ps(a[r + k].e0);
+			ay[k] = _mm256_set1_ps(a[r + k].e1);
+			az[k] = _mm256_set1_ps(a[r + k].e2);
+		}
+		for (std::size_t j = 0; j < full; j += 8) {
+			const __m256 bx = _mm256_load_ps(t.x + j), by = _mm256_load_ps(t.y + j), bz = _mm256_load_ps(t.z + j);
+			for (int k = 0; k < 4; ++k) {
+				__m256 dx = _mm256_sub_ps(bx, ax[k]), dy = _mm256_sub_ps(by, ay[k]), dz = _mm256_sub_ps(bz, az[k]);
+				__m256 d = _mm256_mul_ps(dx, dx);
+				d = _mm256_fmadd_ps(dy, dy, d);
+				d = _mm256_fmadd_ps(dz, dz, d);
+				_mm256_storeu_ps(out + (r + k) * ld + j, d);
+			}
+		}
+		for (std::size_t j = full; j < t.count; ++j) {
+			for (int k = 0; k < 4; ++k) {
+				const float dx = t.x[j] - a[r + k].e0, dy = t.y[j] - a[r + k].e1, dz = t.z[j] - a[r + k].e2;
+				out[(r + k) * ld + j] = sq_norm(dx, dy, dz);
+			}
+		}
+	}
+#endif
+	// portable path (and row remainder): a unit-stride inner loop the compiler can vectorize on its own
+	for (; r < rows; ++r) {
+		const float ax = a[r].e0, ay = a[r].e1, az = a[r].e2;
+		float *row = out + r * ld;
+		for (std::size_t j = 0; j < t.count; ++j) {
+			const float dx = t.x[j] - ax, dy = t.y[j] - ay, dz = t.z[j] - az;
+			row[j] = sq_norm(dx, dy, dz);
+		}
+	}
+}
+
+inline constexpr std::size_t band_rows = 256; // A rows per task
+
+// A full distance matrix is split into task_count() tasks, one per (B tile, band_rows band of A) pair, and each
+// task writes a disjoint block of out (row-major, nb columns), so they can run in any order or in parallel.
+inline std::size_t task_count(std::size_t na, std::size_t nb) {
+	return (nb + tile_cols - 1) / tile_cols * ((na + band_rows - 1) / band_rows);
+}
+
+// Loads the B tile of `task` into tile, then calls step(r, rows, col) for each run of up to tile_rows rows of its
+// band: rows r .. r + rows of A against columns col .. col + tile.count of B.
+template<typename Step>
+void for_each_task_step(std::size_t na, const Vec3 *b, std::size_t nb, std::size_t task, SoATile &tile,
+						Step &&step) {
+	const std::size_t tiles = (nb + tile_cols - 1) / tile_cols;
+	const std::size_t t = task % tiles, band = task / tiles;
+	const std::size_t col = t * tile_cols;
+	tile.load(b + col, std::min(tile_cols, nb - col));
+	const std::size_t row_end = std::min(na, (band + 1) * band_rows);
+	for (std::size_t r = band * band_rows; r < row_end; r += tile_rows) {
+		step(r, std::min(tile_rows, row_end - r), col);
+	}
+}
+
+inline void distance_task(const Vec3 *a, std::size_t na, const Vec3 *b, std::size_t nb, std::size_t task,
+						  SoATile &tile, float *out) {
+	for_each_task_step(na, b, nb, task, tile, [&](std::size_t r, std::size_t rows, std::size_t col) {
+		tile_kernel(a + r, rows, tile, out + r * nb + col, nb);
+	});
+}
+
+} // namespace distance_detail
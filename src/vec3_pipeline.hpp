@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "vec3.hpp"
+
+//================================
+// 			TRANSFORMS
+//================================
+template<typename F>
+concept PointTransformConcept = std::regular_invocable<const F &, Vec3> &&
+								std::convertible_to<std::invoke_result_t<const F &, Vec3>, Vec3>;
+
+template<typename F>
+concept ChunkTransformConcept = std::invocable<const F &, std::span<Vec3>>;
+
+//================================
+// 			BLOCK QUEUE
+//================================
+// Bounded hand-off between two pipeline stages. close() wakes the consumer once the producer is done.
+template<typename T>
+class BlockQueue {
+public:
+	void push(T item) {
+		{
+			std::lock_guard lock(mutex_);
+			items_.push(std::move(item));
+		}
+		cv_.notify_one();
+	}
+
+	std::optional<T> pop() {
+		std::unique_lock lock(mutex_);
+		cv_.wait(lock, [this] { return !items_.empty() || closed_; });
+		if (items_.empty()) {
+			return std::nullopt;
+		}
+		T item = std::move(items_.front());
+		items_.pop();
+		return item;
+	}
+
+	void close() {
+		{
+			std::lock_guard lock(mutex_);
+			closed_ = true;
+		}
+		cv_.notify_all();
+	}
+
+private:
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::queue<T> items_;
+	bool closed_{};
+};
+
+//================================
+// 			STREAMING PIPELINE
+//================================
+struct PipelineOptions {
+	std::size_t chunk_points = std::size_t{ 1 } << 20; // 12 MiB of Vec3 per block
+	std::size_t buffers_per_stage = 2;                   // double buffering between each pair of stages
+	std::size_t grain = 16 * 1024;                       // points per parallel_for task
+};
+
+struct PipelineStats {
+	std::size_t chunks{};
+	std::size_t points{};
+};
+
+// Streams a binary XYZ file (packed Vec3) through `transform` into `out` without holding more than
+// `3 * buffers_per_stage` blocks in memory. Reading, computing and writing run on separate threads,
+// so while block k is being transformed, block k+1 is being read and block k-1 written.
+template<ChunkTransformConcept Transform>
+PipelineStats stream_transform(const std::filesystem::path &in, const std::filesystem::path &out, Transform transform,
+							   PipelineOptions options = {}) {
+	struct Block {
+		std::vector<Vec3> points;
+		std::size_t size{};
+	};
+
+	std::ifstream input(in, std::ios::binary);
+	if (!input) {
+		throw std::runtime_error("cannot open " + in.string());
+	}
+	std::ofstream output(out, std::ios::binary | std::ios::trunc);
+	if (!output) {
+		throw std::runtime_error("cannot open " + out.string());
+	}
+
+	BlockQueue<Block> free_blocks, loaded, computed;
+	for (std::size_t i = 0; i < 3 * std::max<std::size_t>(options.buffers_per_stage, 1); ++i) {
+		free_blocks.push(Block{ std::vector<Vec3>(options.chunk_points), 0 });
+	}
+
+	PipelineStats stats;
+	std::exception_ptr reader_error, writer_error;
+	std::atomic<bool> failed{ false };
+
+	std::jthread reader([&] {
+		try {
+			while (auto block = free_blocks.pop()) {
+				if (failed.load(std::memory_order_relaxed)) {
+					break;
+				}
+				input.read(reinterpret_cast<char *>(block->points.data()),
+						   static_cast<std::streamsize>(block->points.size() * sizeof(Vec3)));
+				auto bytes = static_cast<std::size_t>(input.gcount());
+				if (bytes % sizeof(Vec3) != 0) {
+					throw std::runtime_error("binary XYZ size is not a multiple of 3 floats");
+				}
+				block->size = bytes / sizeof(Vec3);
+				if (block->size == 0) {
+					break;
+				}
+				loaded.push(std::move(*block));
+			}
+		}
+		catch (...) {
+			reader_error = std::current_exception();
+		}
+		loaded.close();
+	});
+
+	std::jthread writer([&] {
+		try {
+			while (auto block = computed.pop()) {
+				output.write(reinterpret_cast<const char *>(block->points.data()),
+							 static_cast<std::streamsize>(block->size * sizeof(Vec3)));
+				if (!output) {
+					throw std::runtime_error("write failed: " + out.string());
+				}
+				++stats.chunks;
+				stats.points += block->size;
+				free_blocks.push(std::move(*block));
+			}
+		}
+		catch (...) {
+			writer_error = std::current_exception();
+			failed = true;
+		}
+		free_blocks.close(); // unblocks the reader if we bailed out early
+	});
+
+	std::exception_ptr compute_error;
+	while (auto block = loaded.pop()) {
+		try {
+			std::span<Vec3> pts(block->points.data(), block->size);
+			parallel_for(pts.size(), options.grain,
+						 [&](std::size_t b, std::size_t e) { transform(pts.subspan(b, e - b)); });
+		}
+		catch (...) {
+			compute_error = std::current_exception();
+			failed = true;
+			free_blocks.close();
+			break;
+		}
+		computed.push(std::move(*block));
+	}
+	if (compute_error) {
+		while (loaded.pop()) {
+			// drain so the reader can finish
+		}
+	}
+	computed.close();
+	reader.join();
+	writer.join();
+
+	for (auto err : { compute_error, reader_error, writer_error }) {
+		if (err) {
+			std::rethrow_exception(err);
+		}
+	}
+	return stats;
+}
+
+// Per-point convenience overload: applies `transform` to every Vec3 of every block.
+template<PointTransformConcept Transform>
+	requires(!ChunkTransformConcept<Transform>)
+PipelineStats stream_transform(const std::filesystem::path &in, const std::filesystem::path &out, Transform transform,
+							   PipelineOptions options = {}) {
+	return stream_transform(
+		in, out,
+		[transform](std::span<Vec3> pts) {
+			for (Vec3 &p : pts) {
+				p = transform(p);
+			}
+		},
+		options);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "morton.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "vec3.hpp"
+
+//================================
+// 			VOXEL GRID
+//================================
+// Sort-based voxel downsampling: every point gets the Morton code of its voxel as a key, keys are radix-sorted
+// together with point indices, and each run of equal keys becomes one centroid. Output voxels come out in
+// Z-order, so the downsampled cloud is already spatially coherent.
+struct VoxelGridOptions {
+	float leaf_size = 0.05f;
+	std::size_t min_points_per_voxel = 1; // voxels with fewer points are dropped
+};
+
+namespace voxel_detail {
+
+// Sorted voxel runs: order[starts[v] .. starts[v + 1]) are the points of voxel v.
+struct VoxelRuns {
+	std::vector<std::uint32_t> order;
+	std::vector<std::size_t> starts;
+};
+
+inline VoxelRuns group_by_voxel(std::span<const Vec3> points, float leaf_size) {
+	if (!(leaf_size > 0)) {
+		throw std::invalid_argument("voxel leaf size must be positive");
+	}
+	if (points.size() >= UINT32_MAX) {
+		throw std::length_error("voxel grid supports up to 2^32 - 1 points");
+	}
+	VoxelRuns runs;
+	const std::size_t n = points.size();
+	if (n == 0) {
+		runs.starts.push_back(0);
+		return runs;
+	}
+
+	const Aabb box = compute_bounds(points);
+	const float inv = 1.0f / leaf_size;
+	const double cells = std::max({ (box.hi.e0 - box.lo.e0) * inv, (box.hi.e1 - box.lo.e1) * inv,
+									(box.hi.e2 - box.lo.e2) * inv }) + 1.0;
+	if (cells > morton::axis_max) {
+		throw std::invalid_argument("voxel leaf size too small for the cloud extent (max 2^21 voxels per axis)");
+	}
+	const int key_bits = 3 * std::bit_width(static_cast<std::uint32_t>(cells));
+
+	std::vector<std::uint64_t> keys(n);
+	runs.order.resize(n);
+	parallel_for(n, 16 * 1024, [&](std::size_t b, std::size_t e) {
+		for (std::size_t i = b; i < e; ++i) {
+			const Vec3 p = points[i];
+			keys[i] = morton::encode(static_cast<std::uint32_t>((p.e0 - box.lo.e0) * inv),
+									 static_cast<std::uint32_t>((p.e1 - box.lo.e1) * inv),
+									 static_cast<std::uint32_t>((p.e2 - box.lo.e2) * inv));
+			runs.order[i] = static_cast<std::uint32_t>(i);
+		}
+	});
+	radix_sort_pairs(std::span(keys), std::span(runs.order), key_bits);
+
+	// run boundaries: count per chunk, prefix, then fill, so the scan is parallel too
+	const std::size_t chunks = std::clamp<std::size_t>(n / (64 * 1024), 1, ThreadPool::current().size());
+	const std::size_t chunk = (n + chunks - 1) / chunks;
+	std::vector<std::size_t> counts(chunks + 1);
+	auto is_start = [&keys](std::size_t i) { return i == 0 || keys[i] != keys[i - 1]; };
+	parallel_for(chunks, 1, [&](std::size_t cb, std::size_t ce) {
+		for (std::size_t c = cb; c < ce; ++c) {
+			std::size_t count = 0;
+			for (std::size_t i = c * chunk, end = std::min(n, (c + 1) * chunk); i < end; ++i) {
+				count += is_start(i);
+			}
+			counts[c + 1] = count;
+		}
+	});
+	std::partial_sum(counts.begin(), counts.end(), counts.begin());
+	runs.starts.resize(counts.back() + 1);
+	parallel_for(chunks, 1, [&](std::size_t cb, std::size_t ce) {
+		for (std::size_t c = cb; c < ce; ++c) {
+			std::size_t out = counts[c];
+			for (std::size_t i = c * chunk, end = std::min(n, (c + 1) * chunk); i < end; ++i) {
+				if (is_start(i)) {
+					runs.starts[out++] = i;
+				}
+			}
+		}
+	});
+	runs.starts.back() = n;
+	return runs;
+}
+
+// Calls emit(voxel, centroid) for every voxel that has enough points, in parallel; voxel ids are dense.
+template<typename Emit>
+std::size_t for_each_centroid(std::span<const Vec3> points, const VoxelRuns &runs, std::size_t min_points,
+							  Emit &&emit) {
+	const std::size_t voxels = runs.starts.size() - 1;
+	// dense output slots for the voxels that survive the min_points filter
+	std::vector<std::size_t> slot(voxels + 1, 0);
+	for (std::size_t v = 0; v < voxels; ++v) {
+		slot[v + 1] = slot[v] + (runs.starts[v + 1] - runs.starts[v] >= min_points);
+	}
+	parallel_for(voxels, 4 * 1024, [&](std::size_t b, std::size_t e) {
+		for (std::size_t v = b; v < e; ++v) {
+			const std::size_t first = runs.starts[v], last = runs.starts[v + 1];
+			if (last - first < min_points) {
+				continue;
+			}
+			double sx = 0, sy = 0, sz = 0; // double accumulators: dense voxels can hold millions of points
+			for (std::size_t i = first; i < last; ++i) {
+				const Vec3 p = points[runs.order[i]];
+				sx += p.e0;
+				sy += p.e1;
+				sz += p.e2;
+			}
+			const double inv = 1.0 / static_cast<double>(last - first);
+			emit(slot[v], Vec3 { .e0 = static_cast<float>(sx * inv), .e1 = static_cast<float>(sy * inv),
+								 .e2 = static_cast<float>(sz * inv) });
+		}
+	});
+	return slot.back();
+}
+
+} // namespace voxel_detail
+
+// One centroid per occupied voxel, as AoS Vec3.
+inline std::vector<Vec3> voxel_downsample(std::span<const Vec3> points, VoxelGridOptions options = {}) {
+	auto runs = voxel_detail::group_by_voxel(points, options.leaf_size);
+	std::vector<Vec3> out(runs.starts.size() - 1);
+	auto kept = voxel_detail::for_each_centroid(points, runs, options.min_points_per_voxel,
+												[&out](std::size_t i, Vec3 c) { out[i] = c; });
+	out.resize(kept);
+	return out;
+}
+
+// Same as voxel_downsample(), written as SoA for consumers that run SIMD over one axis at a time.
+inline Vec3SoA voxel_downsample_soa(std::span<const Vec3> points, VoxelGridOptions options = {}) {
+	auto runs = voxel_detail::group_by_voxel(points, options.leaf_size);
+	Vec3SoA out;
+	out.resize(runs.starts.size() - 1);
+	auto kept = voxel_detail::for_each_centroid(points, runs, options.min_points_per_voxel,
+												[&out](std::size_t i, Vec3 c) {
+													out.x[i] = c.e0;
+													out.y[i] = c.e1;
+													out.z[i] = c.e2;
+												});
+	out.resize(kept);
+	return out;
+}